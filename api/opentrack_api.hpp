@@ -3,6 +3,7 @@
 #include <string>
 #include <array>
 #include <cstring>
+#include <cstdlib>
 #include <memory>
 #include <stdexcept>
 #include <chrono>
@@ -24,7 +25,10 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netdb.h>
+#include <net/if.h>
 #include <unistd.h>
+#include <fcntl.h>
 #endif
 
 namespace opentrack {
@@ -34,6 +38,30 @@ constexpr int DEFAULT_PORT = 9000;
 constexpr size_t MAX_SERIAL_LENGTH = 15;
 constexpr size_t MAX_BATCH_SIZE = 8;
 constexpr size_t PACKET_SIZE = 45;
+constexpr size_t STATUS_PACKET_SIZE = 22;
+constexpr size_t FEEDBACK_PACKET_SIZE = 19;
+constexpr size_t SEQUENCE_SIZE = 4;
+constexpr size_t CAPTURE_TIME_SIZE = 8;
+constexpr size_t CLOCK_PING_PACKET_SIZE = 9;
+constexpr size_t CLOCK_ECHO_PACKET_SIZE = 25;
+
+// Non-pose message markers (first byte)
+constexpr uint8_t PACKET_TYPE_STATUS = 0xF0;
+constexpr uint8_t PACKET_TYPE_FEEDBACK = 0xF1;
+constexpr uint8_t PACKET_TYPE_CLOCK_PING = 0xF2;
+constexpr uint8_t PACKET_TYPE_CLOCK_ECHO = 0xF3;
+
+// Feedback needed-device bits, tracker roles use 1 << role
+constexpr uint16_t FEEDBACK_DEVICE_HMD = 1 << 8;
+constexpr uint16_t FEEDBACK_DEVICE_LEFT_CONTROLLER = 1 << 9;
+constexpr uint16_t FEEDBACK_DEVICE_RIGHT_CONTROLLER = 1 << 10;
+
+// Feedback older than this is ignored, senders then behave as without it
+constexpr auto FEEDBACK_TIMEOUT = std::chrono::seconds(2);
+
+// Status flags
+constexpr uint8_t STATUS_FLAG_CHARGING = 1 << 0;
+constexpr uint8_t STATUS_FLAG_CONNECTED = 1 << 1;
 
 // Device types
 enum class DeviceType : uint8_t {
@@ -43,6 +71,226 @@ enum class DeviceType : uint8_t {
     RightController = 3
 };
 
+// Body tracker roles. Each sender gets its own set of these trackers in
+// the driver, so several bodies can share one SteamVR host
+enum class TrackerRole : uint8_t {
+    Waist = 0,
+    LeftFoot,
+    RightFoot,
+    LeftKnee,
+    RightKnee,
+    LeftElbow,
+    RightElbow,
+    Chest
+};
+
+// Wire name of a role, sent in the serial field
+inline const char* trackerRoleName(TrackerRole role) {
+    static const char* const names[] = {
+        "Waist", "LeftFoot", "RightFoot", "LeftKnee",
+        "RightKnee", "LeftElbow", "RightElbow", "Chest"
+    };
+    return names[static_cast<size_t>(role)];
+}
+
+// Encode one device packet (PACKET_SIZE bytes) from position xyz and
+// rotation wxyz, as laid out on the wire. Shared with the C API
+inline void encodePosePacket(uint8_t* out, DeviceType type, const char* serial, size_t serial_length, const float pose[7]) {
+    out[0] = static_cast<uint8_t>(type);
+    std::memset(&out[1], 0, MAX_SERIAL_LENGTH + 1);
+    std::memcpy(&out[1], serial, std::min(serial_length, MAX_SERIAL_LENGTH));
+    std::memcpy(&out[17], pose, 7 * sizeof(float));
+}
+
+// Driver feedback, sent to every active sender about twice a second
+struct Feedback {
+    float desiredRateHz = 0.0f;   // rate the driver publishes poses at
+    float loss = -1.0f;           // lost datagrams since the previous feedback 0..1, -1 unknown
+    float latencyMs = 0.0f;       // capture to publish once the clock is synced, else receipt to publish
+    uint16_t neededDevices = 0;   // role bits and FEEDBACK_DEVICE_*
+    uint32_t received = 0;        // datagrams the driver got from this sender
+};
+
+// Decode a feedback datagram, false if it isn't one. Shared with the C API
+inline bool decodeFeedback(const uint8_t* data, size_t size, Feedback& out) {
+    if (size != FEEDBACK_PACKET_SIZE || data[0] != PACKET_TYPE_FEEDBACK) return false;
+    std::memcpy(&out.desiredRateHz, &data[1], sizeof(float));
+    std::memcpy(&out.loss, &data[5], sizeof(float));
+    std::memcpy(&out.latencyMs, &data[9], sizeof(float));
+    std::memcpy(&out.neededDevices, &data[13], sizeof(uint16_t));
+    std::memcpy(&out.received, &data[15], sizeof(uint32_t));
+    return true;
+}
+
+// Sender clock capture times are taken on, in nanoseconds. The driver maps
+// it onto its own clock through ping/echo round trips
+inline int64_t clockNowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Answer a driver clock ping, false if the datagram isn't one. recvNs is
+// when it arrived, see receiveDatagram(). Shared with the C API
+inline bool encodeClockEcho(const uint8_t* ping, size_t size, int64_t recvNs, uint8_t out[CLOCK_ECHO_PACKET_SIZE]) {
+    if (size != CLOCK_PING_PACKET_SIZE || ping[0] != PACKET_TYPE_CLOCK_PING) return false;
+    out[0] = PACKET_TYPE_CLOCK_ECHO;
+    std::memcpy(&out[1], &ping[1], sizeof(int64_t));
+    std::memcpy(&out[9], &recvNs, sizeof(int64_t));
+    const int64_t sendNs = clockNowNs();
+    std::memcpy(&out[17], &sendNs, sizeof(int64_t));
+    return true;
+}
+
+// Feedback arrives on the sending socket, which is polled without blocking
+template <typename Socket>
+inline bool setNonBlocking(Socket sock) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(sock, F_GETFL, 0);
+    return flags >= 0 && fcntl(sock, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Let the kernel stamp when datagrams arrive (Linux, macOS), so a clock
+// ping's receive time doesn't include the wait until the socket is read
+template <typename Socket>
+inline void enableReceiveTimestamps(Socket sock) {
+#if defined(SO_TIMESTAMPNS)
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable));
+#elif defined(SO_TIMESTAMP) && !defined(_WIN32)
+    int enable = 1;
+    setsockopt(sock, SOL_SOCKET, SO_TIMESTAMP, &enable, sizeof(enable));
+#else
+    (void)sock;
+#endif
+}
+
+// Receive one datagram. recvNs is when it arrived on the clockNowNs()
+// clock: the kernel timestamp where there is one, otherwise the time it
+// was read. Shared with the C API
+template <typename Socket>
+inline int receiveDatagram(Socket sock, uint8_t* data, size_t size, sockaddr_storage& from, socklen_t& fromLen, int64_t& recvNs) {
+#ifdef _WIN32
+    fromLen = sizeof(from);
+    const int n = recvfrom(sock, reinterpret_cast<char*>(data), static_cast<int>(size), 0,
+                           reinterpret_cast<sockaddr*>(&from), &fromLen);
+    recvNs = clockNowNs();
+    return n;
+#else
+    iovec io{data, size};
+    alignas(cmsghdr) char control[64];
+    msghdr message{};
+    message.msg_name = &from;
+    message.msg_namelen = sizeof(from);
+    message.msg_iov = &io;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    const int n = static_cast<int>(recvmsg(sock, &message, 0));
+    recvNs = clockNowNs();
+    fromLen = message.msg_namelen;
+    if (n < 0) return n;
+
+    for (cmsghdr* c = CMSG_FIRSTHDR(&message); c; c = CMSG_NXTHDR(&message, c)) {
+        int64_t arrived = -1;
+#if defined(SCM_TIMESTAMPNS)
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS) {
+            timespec ts;
+            std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+            arrived = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+#elif defined(SCM_TIMESTAMP)
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMP) {
+            timeval tv;
+            std::memcpy(&tv, CMSG_DATA(c), sizeof(tv));
+            arrived = static_cast<int64_t>(tv.tv_sec) * 1000000000 + static_cast<int64_t>(tv.tv_usec) * 1000;
+        }
+#endif
+        if (arrived >= 0) {
+            // kernel stamps are wall clock, only how long it waited is used
+            const int64_t wall = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            recvNs -= std::max<int64_t>(0, wall - arrived);
+        }
+    }
+    return n;
+#endif
+}
+
+// Multicast send options, used when the host passed to init() is a
+// multicast group (IPv4 224.0.0.0/4 or IPv6 ff00::/8)
+struct MulticastOptions {
+    int ttl = 1;               // hops, 1 stays on the local network
+    bool loopback = true;      // drivers on this machine receive it too
+    std::string interfaceName; // IPv4 address or IPv6 interface name/index, empty = default
+};
+
+// Resolve a host name, IPv4 or IPv6 address to a UDP destination
+inline bool resolveAddress(const std::string& host, int port, sockaddr_storage& out, socklen_t& outLen) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+    std::memcpy(&out, result->ai_addr, result->ai_addrlen);
+    outLen = static_cast<socklen_t>(result->ai_addrlen);
+    freeaddrinfo(result);
+    return true;
+}
+
+inline bool isMulticastAddress(const sockaddr_storage& addr) {
+    if (addr.ss_family == AF_INET) {
+        return (ntohl(reinterpret_cast<const sockaddr_in&>(addr).sin_addr.s_addr) >> 28) == 0xE;
+    }
+    if (addr.ss_family == AF_INET6) {
+        return reinterpret_cast<const sockaddr_in6&>(addr).sin6_addr.s6_addr[0] == 0xFF;
+    }
+    return false;
+}
+
+// Apply multicast send options to a socket of the given family
+template <typename Socket>
+inline bool setMulticastOptions(Socket sock, int family, const MulticastOptions& options) {
+    bool ok = true;
+    if (family == AF_INET) {
+#ifdef _WIN32
+        const DWORD ttl = options.ttl;
+        const DWORD loop = options.loopback ? 1 : 0;
+#else
+        const unsigned char ttl = static_cast<unsigned char>(options.ttl);
+        const unsigned char loop = options.loopback ? 1 : 0;
+#endif
+        ok = ok && setsockopt(sock, IPPROTO_IP, IP_MULTICAST_TTL, reinterpret_cast<const char*>(&ttl), sizeof(ttl)) == 0;
+        ok = ok && setsockopt(sock, IPPROTO_IP, IP_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop)) == 0;
+        if (!options.interfaceName.empty()) {
+            in_addr iface{};
+            ok = ok && inet_pton(AF_INET, options.interfaceName.c_str(), &iface) == 1 &&
+                 setsockopt(sock, IPPROTO_IP, IP_MULTICAST_IF, reinterpret_cast<const char*>(&iface), sizeof(iface)) == 0;
+        }
+    } else {
+        const int hops = options.ttl;
+        const unsigned int loop = options.loopback ? 1 : 0;
+        ok = ok && setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, reinterpret_cast<const char*>(&hops), sizeof(hops)) == 0;
+        ok = ok && setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, reinterpret_cast<const char*>(&loop), sizeof(loop)) == 0;
+        if (!options.interfaceName.empty()) {
+#ifdef _WIN32
+            const unsigned int index = static_cast<unsigned int>(std::atoi(options.interfaceName.c_str()));
+#else
+            unsigned int index = if_nametoindex(options.interfaceName.c_str());
+            if (index == 0) index = static_cast<unsigned int>(std::atoi(options.interfaceName.c_str()));
+#endif
+            ok = ok && index != 0 &&
+                 setsockopt(sock, IPPROTO_IPV6, IPV6_MULTICAST_IF, reinterpret_cast<const char*>(&index), sizeof(index)) == 0;
+        }
+    }
+    return ok;
+}
+
 // Vector3 for position
 struct Vector3 {
     float x = 0.0f;
@@ -94,12 +342,20 @@ public:
         }
     }
 
-    // Update pose
+    // Update pose, captured now
     void updatePose(const Pose& pose) {
+        updatePose(pose, clockNowNs());
+    }
+
+    // Update pose sampled at captureTimeNs (clockNowNs() clock), e.g. a
+    // camera frame's exposure time. Lets SteamVR predict from the moment
+    // the pose was true rather than when it reached the driver
+    void updatePose(const Pose& pose, int64_t captureTimeNs) {
         std::lock_guard<std::mutex> lock(mutex_);
         Pose normalized_pose = pose;
         normalized_pose.rotation.normalize();
         current_pose_ = normalized_pose;
+        capture_time_ns_ = captureTimeNs;
         has_pose_ = true;
     }
 
@@ -115,6 +371,12 @@ public:
         return has_pose_;
     }
 
+    // When the current pose was captured
+    int64_t getCaptureTime() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return capture_time_ns_;
+    }
+
     // Get serial number
     const std::string& getSerial() const { return serial_; }
 
@@ -125,6 +387,7 @@ private:
     std::string serial_;
     DeviceType type_;
     Pose current_pose_;
+    int64_t capture_time_ns_ = 0;
     bool has_pose_ = false;
     mutable std::mutex mutex_;
 };
@@ -137,7 +400,10 @@ public:
         return instance;
     }
 
-    void init(const std::string& host = "127.0.0.1", int port = DEFAULT_PORT) {
+    // host is a name, an IPv4/IPv6 address or a multicast group, in which
+    // case every driver that joined the group receives the same datagrams
+    void init(const std::string& host = "127.0.0.1", int port = DEFAULT_PORT,
+              const MulticastOptions& multicast = MulticastOptions()) {
         if (initialized_) return;
 
 #ifdef _WIN32
@@ -147,14 +413,36 @@ public:
         }
 #endif
 
-        sock_ = socket(AF_INET, SOCK_DGRAM, 0);
+        // undo what succeeded, so init() can be retried
+        auto fail = [this](const std::string& message) {
+            if (sock_ >= 0) {
+#ifdef _WIN32
+                closesocket(sock_);
+#else
+                close(sock_);
+#endif
+                sock_ = -1;
+            }
+#ifdef _WIN32
+            WSACleanup();
+#endif
+            throw std::runtime_error(message);
+        };
+
+        if (!resolveAddress(host, port, server_addr_, server_addr_len_)) {
+            fail("Failed to resolve " + host);
+        }
+
+        sock_ = socket(server_addr_.ss_family, SOCK_DGRAM, 0);
         if (sock_ < 0) {
-            throw std::runtime_error("Failed to create socket");
+            fail("Failed to create socket");
         }
 
-        server_addr_.sin_family = AF_INET;
-        server_addr_.sin_port = htons(port);
-        inet_pton(AF_INET, host.c_str(), &server_addr_.sin_addr);
+        if (isMulticastAddress(server_addr_) && !setMulticastOptions(sock_, server_addr_.ss_family, multicast)) {
+            fail("Failed to set multicast options");
+        }
+        setNonBlocking(sock_);
+        enableReceiveTimestamps(sock_);
 
         initialized_ = true;
     }
@@ -176,6 +464,10 @@ public:
         return tracker;
     }
 
+    std::shared_ptr<Tracker> createTracker(TrackerRole role) {
+        return createTracker(trackerRoleName(role), DeviceType::Tracker);
+    }
+
     std::shared_ptr<Tracker> getTracker(const std::string& serial) {
         auto it = trackers_.find(serial);
         return it != trackers_.end() ? it->second : nullptr;
@@ -208,48 +500,114 @@ public:
         sendPose(controller);
     }
 
-    void sendBatchUpdate() {
-        if (trackers_.empty()) return;
+    // Send battery/charging/connection state, the driver only
+    // writes these to SteamVR when they change
+    void updateTrackerStatus(const std::string& serial, float battery, bool charging, bool connected = true) {
+        std::array<uint8_t, STATUS_PACKET_SIZE> packet{};
+
+        packet[0] = PACKET_TYPE_STATUS;
+        std::memcpy(&packet[1], serial.c_str(), std::min(serial.length(), MAX_SERIAL_LENGTH));
+        std::memcpy(&packet[17], &battery, sizeof(float));
+        packet[21] = (charging ? STATUS_FLAG_CHARGING : 0) | (connected ? STATUS_FLAG_CONNECTED : 0);
+
+        sendto(sock_, reinterpret_cast<char*>(packet.data()), packet.size(), 0,
+               reinterpret_cast<sockaddr*>(&server_addr_), server_addr_len_);
+    }
+
+    // Send all trackers with valid poses that the driver needs, in batches
+    // of 8. With adaptive sending, calls faster than the driver's desired
+    // rate are skipped; returns whether anything was sent
+    bool sendBatchUpdate() {
+        pollFeedback();
+        if (trackers_.empty()) return false;
+
+        const auto now = std::chrono::steady_clock::now();
+        const float rate = getSendRate();
+        if (rate > 0.0f) {
+            if (now < next_batch_) return false;
+            const auto interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double>(1.0 / rate));
+            next_batch_ = std::max(next_batch_ + interval, now);
+        }
 
         std::vector<std::shared_ptr<Tracker>> active_trackers;
         for (const auto& pair : trackers_) {
-            if (pair.second->hasPose()) {
+            if (pair.second->hasPose() && isDeviceNeeded(*pair.second)) {
                 active_trackers.push_back(pair.second);
             }
         }
 
-        if (active_trackers.empty()) return;
+        if (active_trackers.empty()) return false;
 
-        std::vector<uint8_t> packet(1 + (PACKET_SIZE * active_trackers.size()));
-        packet[0] = static_cast<uint8_t>(active_trackers.size());
+        for (size_t first = 0; first < active_trackers.size(); first += MAX_BATCH_SIZE) {
+            const size_t count = std::min(MAX_BATCH_SIZE, active_trackers.size() - first);
+            std::vector<uint8_t> packet(1 + (PACKET_SIZE * count) + SEQUENCE_SIZE + CAPTURE_TIME_SIZE);
+            packet[0] = static_cast<uint8_t>(count);
 
-        for (size_t i = 0; i < active_trackers.size(); ++i) {
-            const auto& tracker = active_trackers[i];
-            const auto& pose = tracker->getPose();
-            size_t offset = 1 + (i * PACKET_SIZE);
+            int64_t capture = 0;
+            for (size_t i = 0; i < count; ++i) {
+                const Tracker& tracker = *active_trackers[first + i];
+                encodeTracker(&packet[1 + (i * PACKET_SIZE)], tracker);
+                const int64_t trackerCapture = tracker.getCaptureTime();
+                capture = i == 0 ? trackerCapture : std::min(capture, trackerCapture);
+            }
 
-            // Device type
-            packet[offset] = static_cast<uint8_t>(tracker->getType());
+            // Sequence number trailer, lets the driver measure loss, then
+            // the oldest capture time in the batch for pose timing
+            const uint32_t sequence = ++sequence_;
+            std::memcpy(&packet[1 + (PACKET_SIZE * count)], &sequence, SEQUENCE_SIZE);
+            std::memcpy(&packet[1 + (PACKET_SIZE * count) + SEQUENCE_SIZE], &capture, CAPTURE_TIME_SIZE);
 
-            // Serial number
-            std::memset(&packet[offset + 1], 0, MAX_SERIAL_LENGTH);
-            const std::string& serial = tracker->getSerial();
-            std::memcpy(&packet[offset + 1], serial.c_str(), std::min(serial.length(), MAX_SERIAL_LENGTH));
+            sendto(sock_, reinterpret_cast<char*>(packet.data()), packet.size(), 0,
+                   reinterpret_cast<sockaddr*>(&server_addr_), server_addr_len_);
+        }
+        return true;
+    }
 
-            // Position
-            std::memcpy(&packet[offset + 17], &pose.position.x, sizeof(float));
-            std::memcpy(&packet[offset + 21], &pose.position.y, sizeof(float));
-            std::memcpy(&packet[offset + 25], &pose.position.z, sizeof(float));
+    // Adapt send rate and device set to driver feedback (default on)
+    void setAdaptive(bool enabled) { adaptive_ = enabled; }
 
-            // Rotation
-            std::memcpy(&packet[offset + 29], &pose.rotation.w, sizeof(float));
-            std::memcpy(&packet[offset + 33], &pose.rotation.x, sizeof(float));
-            std::memcpy(&packet[offset + 37], &pose.rotation.y, sizeof(float));
-            std::memcpy(&packet[offset + 41], &pose.rotation.z, sizeof(float));
-        }
+    // Latest driver feedback, check hasFeedback() first. With drivers on
+    // several hosts in a multicast group it is merged: the highest rate,
+    // the worst loss and latency, and every device any of them needs
+    const Feedback& getFeedback() {
+        pollFeedback();
+        return feedback_;
+    }
 
-        sendto(sock_, reinterpret_cast<char*>(packet.data()), packet.size(), 0,
-               reinterpret_cast<sockaddr*>(&server_addr_), sizeof(server_addr_));
+    // Feedback arrived within FEEDBACK_TIMEOUT
+    bool hasFeedback() const {
+        return feedback_time_ != std::chrono::steady_clock::time_point{} &&
+               std::chrono::steady_clock::now() - feedback_time_ < FEEDBACK_TIMEOUT;
+    }
+
+    // Batch rate sendBatchUpdate() keeps to, 0 = every call. Backs off
+    // while the driver reports loss
+    float getSendRate() const {
+        if (!adaptive_ || !hasFeedback() || feedback_.desiredRateHz <= 0.0f) return 0.0f;
+        return feedback_.desiredRateHz * rate_scale_;
+    }
+
+    // Whether the driver asked for this device, true without feedback
+    bool isDeviceNeeded(const Tracker& tracker) const {
+        if (!adaptive_ || !hasFeedback()) return true;
+        switch (tracker.getType()) {
+            case DeviceType::HMD:
+                return (feedback_.neededDevices & FEEDBACK_DEVICE_HMD) != 0;
+            case DeviceType::LeftController:
+                return (feedback_.neededDevices & FEEDBACK_DEVICE_LEFT_CONTROLLER) != 0;
+            case DeviceType::RightController:
+                return (feedback_.neededDevices & FEEDBACK_DEVICE_RIGHT_CONTROLLER) != 0;
+            case DeviceType::Tracker:
+                break;
+        }
+        for (uint8_t role = 0; role <= static_cast<uint8_t>(TrackerRole::Chest); ++role) {
+            if (tracker.getSerial() == trackerRoleName(static_cast<TrackerRole>(role))) {
+                return (feedback_.neededDevices & (1u << role)) != 0;
+            }
+        }
+        // Not a role, the driver can't tell
+        return true;
     }
 
 private:
@@ -258,34 +616,109 @@ private:
     TrackerManager& operator=(const TrackerManager&) = delete;
 
     void sendPose(const std::shared_ptr<Tracker>& tracker) {
-        if (!tracker || !tracker->hasPose()) return;
+        pollFeedback();
+        if (!tracker || !tracker->hasPose() || !isDeviceNeeded(*tracker)) return;
 
-        const auto& pose = tracker->getPose();
         std::array<uint8_t, PACKET_SIZE> packet;
+        encodeTracker(packet.data(), *tracker);
 
-        packet[0] = static_cast<uint8_t>(tracker->getType());
+        sendto(sock_, reinterpret_cast<char*>(packet.data()), packet.size(), 0,
+               reinterpret_cast<sockaddr*>(&server_addr_), server_addr_len_);
+    }
 
-        std::memset(&packet[1], 0, MAX_SERIAL_LENGTH);
-        const std::string& serial = tracker->getSerial();
-        std::memcpy(&packet[1], serial.c_str(), std::min(serial.length(), MAX_SERIAL_LENGTH));
+    // Drain feedback datagrams from the driver(s) and answer clock pings.
+    // Pings are stamped by the kernel on arrival where it can; elsewhere
+    // (Windows) they wait in the socket until this runs, and senders that
+    // call it more often get a tighter clock estimate
+    void pollFeedback() {
+        if (!initialized_) return;
+        const auto now = std::chrono::steady_clock::now();
+        uint8_t buffer[64];
+        Feedback feedback;
+        bool changed = false;
+        for (;;) {
+            sockaddr_storage from{};
+            socklen_t fromLen = sizeof(from);
+            int64_t recvNs = 0;
+            const int n = receiveDatagram(sock_, buffer, sizeof(buffer), from, fromLen, recvNs);
+            if (n <= 0) break;
+
+            uint8_t echo[CLOCK_ECHO_PACKET_SIZE];
+            if (encodeClockEcho(buffer, static_cast<size_t>(n), recvNs, echo)) {
+                sendto(sock_, reinterpret_cast<char*>(echo), sizeof(echo), 0,
+                       reinterpret_cast<sockaddr*>(&from), fromLen);
+                continue;
+            }
+            if (!decodeFeedback(buffer, static_cast<size_t>(n), feedback)) continue;
 
-        std::memcpy(&packet[17], &pose.position.x, sizeof(float));
-        std::memcpy(&packet[21], &pose.position.y, sizeof(float));
-        std::memcpy(&packet[25], &pose.position.z, sizeof(float));
+            auto source = std::find_if(feedback_sources_.begin(), feedback_sources_.end(), [&](const FeedbackSource& s) {
+                return s.addrLen == fromLen && std::memcmp(&s.addr, &from, fromLen) == 0;
+            });
+            if (source == feedback_sources_.end()) {
+                source = feedback_sources_.insert(feedback_sources_.end(), FeedbackSource{from, fromLen, {}, {}});
+            }
+            source->feedback = feedback;
+            source->time = now;
+            feedback_time_ = now;
+            changed = true;
+
+            // Back off quickly on loss, recover slowly
+            if (feedback.loss > 0.05f) {
+                rate_scale_ = std::max(0.25f, rate_scale_ * 0.75f);
+            } else if (feedback.loss >= 0.0f && feedback.loss < 0.01f) {
+                rate_scale_ = std::min(1.0f, rate_scale_ + 0.05f);
+            }
+        }
 
-        std::memcpy(&packet[29], &pose.rotation.w, sizeof(float));
-        std::memcpy(&packet[33], &pose.rotation.x, sizeof(float));
-        std::memcpy(&packet[37], &pose.rotation.y, sizeof(float));
-        std::memcpy(&packet[41], &pose.rotation.z, sizeof(float));
+        // drop drivers that went quiet, merge the rest
+        const size_t sources = feedback_sources_.size();
+        feedback_sources_.erase(std::remove_if(feedback_sources_.begin(), feedback_sources_.end(),
+            [&](const FeedbackSource& s) { return now - s.time >= FEEDBACK_TIMEOUT; }), feedback_sources_.end());
+        if (!changed && sources == feedback_sources_.size()) return;
+        if (feedback_sources_.empty()) return;
+
+        Feedback merged = feedback_sources_.front().feedback;
+        for (const auto& s : feedback_sources_) {
+            merged.desiredRateHz = std::max(merged.desiredRateHz, s.feedback.desiredRateHz);
+            merged.loss = std::max(merged.loss, s.feedback.loss);
+            merged.latencyMs = std::max(merged.latencyMs, s.feedback.latencyMs);
+            merged.neededDevices |= s.feedback.neededDevices;
+            merged.received = std::min(merged.received, s.feedback.received);
+        }
+        feedback_ = merged;
+    }
 
-        sendto(sock_, reinterpret_cast<char*>(packet.data()), packet.size(), 0,
-               reinterpret_cast<sockaddr*>(&server_addr_), sizeof(server_addr_));
+    // Feedback from one driver
+    struct FeedbackSource {
+        sockaddr_storage addr;
+        socklen_t addrLen;
+        Feedback feedback;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    static void encodeTracker(uint8_t* out, const Tracker& tracker) {
+        const Pose pose = tracker.getPose();
+        const float data[7] = {
+            pose.position.x, pose.position.y, pose.position.z,
+            pose.rotation.w, pose.rotation.x, pose.rotation.y, pose.rotation.z
+        };
+        const std::string& serial = tracker.getSerial();
+        encodePosePacket(out, tracker.getType(), serial.c_str(), serial.length(), data);
     }
 
     std::map<std::string, std::shared_ptr<Tracker>> trackers_;
     int sock_ = -1;
-    sockaddr_in server_addr_{};
+    sockaddr_storage server_addr_{};
+    socklen_t server_addr_len_ = 0;
     bool initialized_ = false;
+
+    bool adaptive_ = true;
+    std::vector<FeedbackSource> feedback_sources_;
+    Feedback feedback_;
+    std::chrono::steady_clock::time_point feedback_time_{};
+    std::chrono::steady_clock::time_point next_batch_{};
+    float rate_scale_ = 1.0f;
+    uint32_t sequence_ = 0;
 };
 
 } // namespace opentrack
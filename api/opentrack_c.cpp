@@ -0,0 +1,211 @@
+#include "opentrack_c.h"
+#include "opentrack_api.hpp"
+
+using namespace opentrack;
+
+struct opentrack_session {
+#ifdef _WIN32
+    SOCKET sock = INVALID_SOCKET;
+#else
+    int sock = -1;
+#endif
+    sockaddr_storage server_addr{};
+    socklen_t server_addr_len = 0;
+    std::atomic<uint32_t> sequence{0};
+};
+
+namespace {
+
+constexpr size_t kNumRoles = 8;
+
+// device type and wire serial of a slot, false if unknown
+bool resolveSlot(uint8_t slot, DeviceType& type, const char*& serial) {
+    if (slot < kNumRoles) {
+        type = DeviceType::Tracker;
+        serial = trackerRoleName(static_cast<TrackerRole>(slot));
+        return true;
+    }
+    switch (slot) {
+        case OPENTRACK_SLOT_HMD:
+            type = DeviceType::HMD;
+            serial = "HMD";
+            return true;
+        case OPENTRACK_SLOT_LEFT_CONTROLLER:
+            type = DeviceType::LeftController;
+            serial = "LeftController";
+            return true;
+        case OPENTRACK_SLOT_RIGHT_CONTROLLER:
+            type = DeviceType::RightController;
+            serial = "RightController";
+            return true;
+    }
+    return false;
+}
+
+bool sendDatagram(opentrack_session* session, const uint8_t* data, size_t size) {
+    return sendto(session->sock, reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+                  reinterpret_cast<const sockaddr*>(&session->server_addr), session->server_addr_len) == static_cast<int>(size);
+}
+
+} // namespace
+
+extern "C" {
+
+uint32_t opentrack_abi_version(void) {
+    return OPENTRACK_C_ABI_VERSION;
+}
+
+opentrack_session* opentrack_session_create(const char* host, int port) {
+#ifdef _WIN32
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        return nullptr;
+    }
+#endif
+
+    auto* session = new opentrack_session();
+    if (!resolveAddress(host ? host : "127.0.0.1", port > 0 ? port : DEFAULT_PORT,
+                        session->server_addr, session->server_addr_len)) {
+        delete session;
+#ifdef _WIN32
+        WSACleanup();
+#endif
+        return nullptr;
+    }
+    session->sock = socket(session->server_addr.ss_family, SOCK_DGRAM, 0);
+#ifdef _WIN32
+    if (session->sock == INVALID_SOCKET) {
+        delete session;
+        WSACleanup();
+        return nullptr;
+    }
+#else
+    if (session->sock < 0) {
+        delete session;
+        return nullptr;
+    }
+#endif
+    setNonBlocking(session->sock);
+    enableReceiveTimestamps(session->sock);
+    // defaults, a group can be used without opentrack_session_set_multicast
+    if (isMulticastAddress(session->server_addr)) {
+        setMulticastOptions(session->sock, session->server_addr.ss_family, MulticastOptions());
+    }
+    return session;
+}
+
+int opentrack_session_set_multicast(opentrack_session* session, int ttl, int loopback, const char* iface) {
+    if (!session || ttl < 0 || ttl > 255 || !isMulticastAddress(session->server_addr)) {
+        return OPENTRACK_ERROR_INVALID_ARGUMENT;
+    }
+    MulticastOptions options;
+    options.ttl = ttl;
+    options.loopback = loopback != 0;
+    options.interfaceName = iface ? iface : "";
+    return setMulticastOptions(session->sock, session->server_addr.ss_family, options) ? OPENTRACK_OK : OPENTRACK_ERROR_SOCKET;
+}
+
+void opentrack_session_destroy(opentrack_session* session) {
+    if (!session) return;
+#ifdef _WIN32
+    closesocket(session->sock);
+    WSACleanup();
+#else
+    close(session->sock);
+#endif
+    delete session;
+}
+
+int64_t opentrack_clock_ns(void) {
+    return clockNowNs();
+}
+
+int opentrack_submit(opentrack_session* session, const float* poses, const uint8_t* slots, size_t count) {
+    return opentrack_submit_captured(session, poses, slots, count, clockNowNs());
+}
+
+int opentrack_submit_captured(opentrack_session* session, const float* poses, const uint8_t* slots, size_t count, int64_t capture_ns) {
+    if (!session || (count > 0 && (!poses || !slots))) {
+        return OPENTRACK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // resolve everything first, so a bad slot sends nothing
+    for (size_t i = 0; i < count; ++i) {
+        DeviceType type;
+        const char* serial;
+        if (!resolveSlot(slots[i], type, serial)) {
+            return OPENTRACK_ERROR_INVALID_ARGUMENT;
+        }
+    }
+
+    int sent = 0;
+    for (size_t first = 0; first < count; first += MAX_BATCH_SIZE) {
+        size_t devices = std::min(MAX_BATCH_SIZE, count - first);
+        uint8_t packet[1 + PACKET_SIZE * MAX_BATCH_SIZE + SEQUENCE_SIZE + CAPTURE_TIME_SIZE];
+        packet[0] = static_cast<uint8_t>(devices);
+        for (size_t i = 0; i < devices; ++i) {
+            DeviceType type;
+            const char* serial;
+            resolveSlot(slots[first + i], type, serial);
+            encodePosePacket(&packet[1 + i * PACKET_SIZE], type, serial, std::strlen(serial),
+                             &poses[(first + i) * OPENTRACK_POSE_FLOATS]);
+        }
+        const uint32_t sequence = session->sequence.fetch_add(1, std::memory_order_relaxed) + 1;
+        std::memcpy(&packet[1 + PACKET_SIZE * devices], &sequence, SEQUENCE_SIZE);
+        std::memcpy(&packet[1 + PACKET_SIZE * devices + SEQUENCE_SIZE], &capture_ns, CAPTURE_TIME_SIZE);
+        if (!sendDatagram(session, packet, 1 + PACKET_SIZE * devices + SEQUENCE_SIZE + CAPTURE_TIME_SIZE)) {
+            return OPENTRACK_ERROR_SOCKET;
+        }
+        ++sent;
+    }
+    return sent;
+}
+
+int opentrack_submit_status(opentrack_session* session, uint8_t slot, float battery, int charging, int connected) {
+    if (!session || slot >= kNumRoles) {
+        return OPENTRACK_ERROR_INVALID_ARGUMENT;
+    }
+
+    const char* serial = trackerRoleName(static_cast<TrackerRole>(slot));
+    uint8_t packet[STATUS_PACKET_SIZE] = {};
+    packet[0] = PACKET_TYPE_STATUS;
+    std::memcpy(&packet[1], serial, std::min(std::strlen(serial), MAX_SERIAL_LENGTH));
+    std::memcpy(&packet[17], &battery, sizeof(float));
+    packet[21] = (charging ? STATUS_FLAG_CHARGING : 0) | (connected ? STATUS_FLAG_CONNECTED : 0);
+    return sendDatagram(session, packet, sizeof(packet)) ? 1 : OPENTRACK_ERROR_SOCKET;
+}
+
+int opentrack_poll_feedback(opentrack_session* session, opentrack_feedback* out) {
+    if (!session || !out) {
+        return OPENTRACK_ERROR_INVALID_ARGUMENT;
+    }
+
+    // keep only the newest, echo pings right away
+    uint8_t buffer[64];
+    Feedback feedback;
+    int found = 0;
+    for (;;) {
+        sockaddr_storage from{};
+        socklen_t fromLen = sizeof(from);
+        int64_t recvNs = 0;
+        const int n = receiveDatagram(session->sock, buffer, sizeof(buffer), from, fromLen, recvNs);
+        if (n <= 0) break;
+        uint8_t echo[CLOCK_ECHO_PACKET_SIZE];
+        if (encodeClockEcho(buffer, static_cast<size_t>(n), recvNs, echo)) {
+            sendto(session->sock, reinterpret_cast<const char*>(echo), sizeof(echo), 0,
+                   reinterpret_cast<const sockaddr*>(&from), fromLen);
+            continue;
+        }
+        if (decodeFeedback(buffer, static_cast<size_t>(n), feedback)) found = 1;
+    }
+    if (found) {
+        out->desired_rate_hz = feedback.desiredRateHz;
+        out->loss = feedback.loss;
+        out->latency_ms = feedback.latencyMs;
+        out->needed_devices = feedback.neededDevices;
+        out->received = feedback.received;
+    }
+    return found;
+}
+
+} // extern "C"
@@ -0,0 +1,128 @@
+/*
+ * C ABI for the OpenTrackDriver client API, for senders written in other
+ * languages. Poses are submitted in bulk from a caller-owned array and
+ * encoded straight into the datagram.
+ */
+#ifndef OPENTRACK_C_H
+#define OPENTRACK_C_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#  ifdef OPENTRACK_C_BUILD
+#    define OPENTRACK_C_API __declspec(dllexport)
+#  else
+#    define OPENTRACK_C_API __declspec(dllimport)
+#  endif
+#else
+#  define OPENTRACK_C_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped on incompatible changes */
+#define OPENTRACK_C_ABI_VERSION 1
+
+/* floats per pose: position xyz, rotation wxyz */
+#define OPENTRACK_POSE_FLOATS 7
+
+/* devices per datagram, larger submits are split */
+#define OPENTRACK_MAX_BATCH 8
+
+/* slot ids, tracker slots match the driver's roles */
+enum {
+    OPENTRACK_SLOT_WAIST = 0,
+    OPENTRACK_SLOT_LEFT_FOOT = 1,
+    OPENTRACK_SLOT_RIGHT_FOOT = 2,
+    OPENTRACK_SLOT_LEFT_KNEE = 3,
+    OPENTRACK_SLOT_RIGHT_KNEE = 4,
+    OPENTRACK_SLOT_LEFT_ELBOW = 5,
+    OPENTRACK_SLOT_RIGHT_ELBOW = 6,
+    OPENTRACK_SLOT_CHEST = 7,
+    OPENTRACK_SLOT_HMD = 0x40,
+    OPENTRACK_SLOT_LEFT_CONTROLLER = 0x41,
+    OPENTRACK_SLOT_RIGHT_CONTROLLER = 0x42
+};
+
+/* opentrack_feedback.needed_devices bits, tracker slots use 1 << slot */
+#define OPENTRACK_NEEDED_HMD (1 << 8)
+#define OPENTRACK_NEEDED_LEFT_CONTROLLER (1 << 9)
+#define OPENTRACK_NEEDED_RIGHT_CONTROLLER (1 << 10)
+
+/* error codes, all negative */
+enum {
+    OPENTRACK_OK = 0,
+    OPENTRACK_ERROR_INVALID_ARGUMENT = -1,
+    OPENTRACK_ERROR_SOCKET = -2
+};
+
+typedef struct opentrack_session opentrack_session;
+
+/* driver feedback, see docs/UDP_API.md */
+typedef struct opentrack_feedback {
+    float desired_rate_hz;   /* rate the driver publishes poses at */
+    float loss;              /* lost datagrams since the previous feedback 0..1, -1 unknown */
+    float latency_ms;        /* capture to publish once the clock is synced, else receipt to publish */
+    uint16_t needed_devices; /* OPENTRACK_NEEDED_* and tracker slot bits */
+    uint32_t received;       /* datagrams the driver got from this session */
+} opentrack_feedback;
+
+/* OPENTRACK_C_ABI_VERSION the library was built with */
+OPENTRACK_C_API uint32_t opentrack_abi_version(void);
+
+/*
+ * open a sender to host:port (port 0 = 9000), NULL on failure. host is a
+ * name, an IPv4/IPv6 address or a multicast group
+ */
+OPENTRACK_C_API opentrack_session* opentrack_session_create(const char* host, int port);
+
+/*
+ * multicast send options for a session created with a group address:
+ * ttl in hops (1 stays on the local network), loopback 0 or 1, iface an
+ * IPv4 address or IPv6 interface name/index, NULL for the default
+ */
+OPENTRACK_C_API int opentrack_session_set_multicast(opentrack_session* session, int ttl, int loopback, const char* iface);
+
+OPENTRACK_C_API void opentrack_session_destroy(opentrack_session* session);
+
+/* sender clock in nanoseconds, the clock capture times are taken on */
+OPENTRACK_C_API int64_t opentrack_clock_ns(void);
+
+/*
+ * Send count poses: poses is count * OPENTRACK_POSE_FLOATS floats,
+ * slots holds the slot id of each row. Rotations are sent as given and
+ * should be normalized. Each datagram carries a sequence number so the
+ * driver can report loss, and the time of the call as capture time.
+ * Returns the number of datagrams sent or an error.
+ * Safe to call from several threads on the same session.
+ */
+OPENTRACK_C_API int opentrack_submit(opentrack_session* session, const float* poses, const uint8_t* slots, size_t count);
+
+/*
+ * opentrack_submit for poses sampled at capture_ns (opentrack_clock_ns()
+ * clock), e.g. a camera frame's exposure time. The driver maps it onto its
+ * own clock once synced, see opentrack_poll_feedback
+ */
+OPENTRACK_C_API int opentrack_submit_captured(opentrack_session* session, const float* poses, const uint8_t* slots, size_t count, int64_t capture_ns);
+
+/* battery 0..1, charging/connected 0 or 1; tracker slots only */
+OPENTRACK_C_API int opentrack_submit_status(opentrack_session* session, uint8_t slot, float battery, int charging, int connected);
+
+/*
+ * Latest driver feedback received since the previous call, without
+ * blocking. Returns 1 and fills out if there was any, 0 if not. On a
+ * multicast group this is the newest packet from any driver.
+ * Also answers the driver's clock pings, so call it regularly (every
+ * submit is fine) for capture times to be used.
+ * Call from one thread at a time.
+ */
+OPENTRACK_C_API int opentrack_poll_feedback(opentrack_session* session, opentrack_feedback* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPENTRACK_C_H */
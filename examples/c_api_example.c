@@ -0,0 +1,48 @@
+/* bulk submit through the C ABI: one call per frame for the whole body */
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 199309L
+#endif
+#include "opentrack_c.h"
+#include <stdio.h>
+#ifdef _WIN32
+#include <windows.h>
+#define sleep_ms(ms) Sleep(ms)
+#else
+#include <time.h>
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+#endif
+
+int main(void) {
+    opentrack_session* session = opentrack_session_create("127.0.0.1", 9000);
+    if (!session) {
+        fprintf(stderr, "failed to open session\n");
+        return 1;
+    }
+
+    /* waist and both feet, position xyz + rotation wxyz per row */
+    const uint8_t slots[3] = { OPENTRACK_SLOT_WAIST, OPENTRACK_SLOT_LEFT_FOOT, OPENTRACK_SLOT_RIGHT_FOOT };
+    float poses[3 * OPENTRACK_POSE_FLOATS] = {
+         0.0f, 1.0f, 0.0f,  1.0f, 0.0f, 0.0f, 0.0f,
+        -0.2f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f, 0.0f,
+         0.2f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f, 0.0f
+    };
+
+    opentrack_feedback feedback;
+    for (int frame = 0; frame < 900; ++frame) {
+        /* also answers clock pings, so the driver can time the poses */
+        opentrack_poll_feedback(session, &feedback);
+        poses[1] = 1.0f + 0.05f * (frame % 90) / 90.0f; /* waist height */
+        if (opentrack_submit(session, poses, slots, 3) < 0) {
+            fprintf(stderr, "submit failed\n");
+            break;
+        }
+        sleep_ms(11);
+    }
+
+    opentrack_submit_status(session, OPENTRACK_SLOT_WAIST, 0.9f, 0, 1);
+    opentrack_session_destroy(session);
+    return 0;
+}
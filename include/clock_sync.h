@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace vr {
+
+// ntp style estimate of a sender's clock against the driver's, from
+// ping/echo round trips:
+//   sender = driver + offset + drift * (driver - ref)
+// the lowest delay round trip of the last few carries the least queueing
+// asymmetry, only those correct the estimate
+class ClockSync {
+public:
+    // one round trip: driver send, sender receive, sender send, driver receive
+    void AddSample(int64_t driver_send_ns, int64_t sender_recv_ns, int64_t sender_send_ns, int64_t driver_recv_ns);
+
+    // enough round trips for a usable estimate
+    bool IsSynced() const { return samples_ >= kMinSamples; }
+
+    // sender clock to driver clock
+    int64_t ToDriverTime(int64_t sender_ns) const;
+
+    double GetOffsetMs() const { return offset_ns_ / 1e6; }
+    double GetDriftPpm() const { return drift_ * 1e6; }
+    int64_t GetRoundTripNs() const;
+
+    void Reset() { *this = ClockSync(); }
+
+private:
+    struct Sample {
+        int64_t driver_ns; // midpoint of the round trip
+        int64_t offset_ns;
+        int64_t delay_ns;
+    };
+
+    static constexpr size_t kWindow = 8;
+    static constexpr uint32_t kMinSamples = 3;
+
+    std::array<Sample, kWindow> window_{};
+    uint32_t samples_ = 0;
+    int64_t ref_ns_ = 0;     // driver time offset_ns_ holds for, 0 = no estimate
+    int64_t first_ref_ns_ = 0; // ref_ns_ of the first estimate
+    double offset_ns_ = 0.0;
+    double drift_ = 0.0;     // sender ns gained per driver ns
+};
+
+} // namespace vr
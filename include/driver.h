@@ -4,6 +4,7 @@
 #include <memory>
 #include <openvr_driver.h>
 #include "tracker_device_driver.h"
+#include "tracker_pose_publisher.h"
 
 namespace vr {
 
@@ -22,6 +23,10 @@ public:
 
 private:
     std::vector<std::shared_ptr<TrackerDeviceDriver>> trackers_;
+    TrackerPosePublisher publisher_;
+    int64_t last_frame_ns_ = 0;
+    double frame_rate_hz_ = 0.0; // RunFrame rate, averaged
+    bool standby_ = false;
 };
 
 } // namespace vr 
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "skeleton_solver.h"
+
+namespace vr {
+
+// settings section in steamvr.vrsettings
+constexpr const char* k_pchSettingsSection = "driver_OpenTrackDriver";
+
+struct DriverSettings {
+    int port = 9000;               // udp port
+    int ingest_workers = 1;        // udp ingest threads
+    std::string multicast_group;   // multicast group to join, empty for unicast only
+    int max_senders = 1;           // slot sets, one body per sender
+    int session_timeout_ms = 3000; // sender silence before its slot set is freed
+    int publish_rate_hz = 0;       // pose publisher thread rate, 0 publishes in RunFrame
+    bool publish_follow_display = false; // publisher tracks the hmd refresh rate
+    int trace_events = 0;          // trace ring size per thread, 0 disables tracing
+    std::string trace_path;        // chrome trace json written at shutdown
+    bool sender_feedback = true;   // send rate/loss/device feedback to senders
+    bool clock_sync = true;        // ping senders to time poses by capture
+    bool derive_trackers = false;  // solve knees, elbows and chest a sender doesn't stream
+    std::vector<BodyProportions> bodies; // per slot set (not per sender), keys with a _<set> suffix override set > 0
+
+    // read overrides, missing keys keep defaults
+    static DriverSettings Load();
+};
+
+} // namespace vr
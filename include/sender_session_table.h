@@ -0,0 +1,91 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include "clock_sync.h"
+
+namespace vr {
+
+// sender address, ipv4 is stored ipv4-mapped
+struct SenderKey {
+    uint8_t addr[16];
+    uint16_t port;
+
+    bool operator==(const SenderKey& other) const {
+        return port == other.port && memcmp(addr, other.addr, sizeof(addr)) == 0;
+    }
+};
+
+SenderKey MakeSenderKey(uint32_t ipv4_addr, uint16_t port);
+SenderKey MakeSenderKey(const uint8_t ipv6_addr[16], uint16_t port);
+
+struct SenderSession {
+    SenderKey key{};
+    uint32_t id = 0;             // session id, 0 = empty entry
+    int slot_set = -1;           // owned slot set, -1 = none
+    int64_t last_seen_ns = 0;    // last datagram
+    int64_t last_acquire_ns = 0; // last slot set attempt
+    uint32_t scope_id = 0;       // ipv6 link-local scope, for replies
+
+    // feedback, loss needs sequence numbers from the sender
+    uint32_t received = 0;          // datagrams from this sender
+    bool has_sequence = false;
+    uint32_t last_sequence = 0;
+    uint32_t interval_received = 0; // sequenced datagrams since last feedback
+    uint32_t interval_expected = 0;
+    int64_t last_feedback_ns = 0;
+
+    // clock sync, only echoes of the latest ping count
+    ClockSync clock;
+    int64_t last_ping_ns = 0;
+
+    // standby, newest pose datagram until the queue drains
+    char standby_datagram[384]{}; // 8 device batch with trailer
+    size_t standby_size = 0;      // 0 = none
+    int64_t standby_recv_ns = 0;
+};
+
+// fixed capacity open addressing table, never allocates
+class SenderSessionTable {
+public:
+    static constexpr size_t kCapacity = 64;
+    static constexpr size_t kMaxSessions = kCapacity / 2;
+
+    SenderSession* Find(const SenderKey& key);
+
+    // nullptr when full
+    SenderSession* Insert(const SenderKey& key, uint32_t id);
+
+    // erase every session pred returns true for
+    template <typename Pred>
+    void EraseIf(Pred&& pred) {
+        for (size_t i = 0; i < kCapacity;) {
+            if (entries_[i].id != 0 && pred(entries_[i])) {
+                // slot refilled by backward shift, check it again
+                EraseAt(i);
+                continue;
+            }
+            ++i;
+        }
+    }
+
+    template <typename Fn>
+    void ForEach(Fn&& fn) {
+        for (auto& entry : entries_) {
+            if (entry.id != 0) fn(entry);
+        }
+    }
+
+    size_t Size() const { return size_; }
+
+private:
+    static size_t Hash(const SenderKey& key);
+    void EraseAt(size_t index);
+
+    std::array<SenderSession, kCapacity> entries_{};
+    size_t size_ = 0;
+};
+
+} // namespace vr
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <openvr_driver.h>
+
+namespace vr {
+
+// segment lengths and joint offsets in meters
+struct BodyProportions {
+    float thigh = 0.43f;             // hip joint to knee
+    float shin = 0.43f;              // knee to foot tracker
+    float upper_arm = 0.33f;         // shoulder to elbow
+    float forearm = 0.28f;           // elbow to controller
+    float hip_width = 0.18f;         // between hip joints
+    float shoulder_width = 0.35f;    // between shoulder joints
+    float hip_to_chest = 0.33f;      // waist tracker to chest tracker along the spine
+    float chest_to_shoulder = 0.11f; // chest tracker up to the shoulder line
+    float neck_drop = 0.19f;         // hmd down to the base of the neck
+    float neck_back = 0.09f;         // hmd back to the base of the neck
+
+    // average proportions scaled to a standing height
+    static BodyProportions FromHeight(float height);
+};
+
+struct JointPose {
+    HmdVector3_t position;
+    HmdQuaternion_t rotation;
+};
+
+// chest on the spine between the waist tracker and the neck below the hmd
+JointPose SolveChest(const BodyProportions& body, const JointPose& hip, const JointPose& head);
+
+// two-bone ik from the hip joint to the foot tracker, knees bend forward
+JointPose SolveKnee(const BodyProportions& body, const JointPose& hip, const JointPose& foot, bool left);
+
+// two-bone ik from the shoulder to the controller, elbows bend down and back
+JointPose SolveElbow(const BodyProportions& body, const JointPose& chest, const JointPose& hand, bool left);
+
+} // namespace vr
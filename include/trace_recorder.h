@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace vr {
+
+// opt-in event tracing, one lock-free ring per thread, dumped as chrome
+// trace json (chrome://tracing, ui.perfetto.dev)
+class TraceRecorder {
+public:
+    static TraceRecorder& GetInstance();
+
+    // start recording into rings of events_per_thread, 0 stops; only while
+    // no other thread is recording (before ingest starts / after it stops)
+    void Enable(size_t events_per_thread, const std::string& path);
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // label the calling thread in the dump
+    void SetThreadName(const std::string& name);
+
+    // name and arg_name must outlive the recorder (string literals)
+    void Instant(const char* name, const char* arg_name, int64_t arg);
+    void Complete(const char* name, int64_t start_ns, const char* arg_name, int64_t arg);
+
+    static int64_t Now();
+
+    // dump what is still in the rings, path empty uses the enable path;
+    // returns events written, -1 on error
+    int64_t WriteChromeTrace(const std::string& path = std::string());
+
+private:
+    struct Event {
+        std::atomic<int64_t> ts_ns{0};
+        std::atomic<int64_t> dur_ns{-1}; // -1 = instant
+        std::atomic<const char*> name{nullptr};
+        std::atomic<const char*> arg_name{nullptr};
+        std::atomic<int64_t> arg{0};
+    };
+
+    // written by its thread only, read by dumps
+    struct ThreadBuffer {
+        ThreadBuffer(size_t capacity, uint32_t tid) : events(new Event[capacity]), capacity(capacity), tid(tid) {}
+        std::unique_ptr<Event[]> events;
+        size_t capacity;
+        uint32_t tid;
+        std::atomic<uint64_t> head{0};
+        std::string name; // under buffers_mutex_
+    };
+
+    TraceRecorder() = default;
+    ThreadBuffer* GetThreadBuffer();
+    void Record(const char* name, int64_t ts_ns, int64_t dur_ns, const char* arg_name, int64_t arg);
+
+    static std::atomic<bool> enabled_;
+    std::atomic<uint64_t> epoch_{0};
+    size_t events_per_thread_ = 0;
+    int64_t start_ns_ = 0;
+    std::string path_;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+    std::mutex buffers_mutex_;
+};
+
+// records a complete event over its lifetime
+class TraceScope {
+public:
+    TraceScope(const char* name, const char* arg_name = nullptr, int64_t arg = 0)
+        : name_(name), arg_name_(arg_name), arg_(arg), start_ns_(TraceRecorder::IsEnabled() ? TraceRecorder::Now() : 0) {}
+    ~TraceScope() {
+        if (start_ns_ != 0 && TraceRecorder::IsEnabled())
+            TraceRecorder::GetInstance().Complete(name_, start_ns_, arg_name_, arg_);
+    }
+
+private:
+    const char* name_;
+    const char* arg_name_;
+    int64_t arg_;
+    int64_t start_ns_;
+};
+
+// instant event, a relaxed load when tracing is off
+inline void TraceInstant(const char* name, const char* arg_name = nullptr, int64_t arg = 0) {
+    if (TraceRecorder::IsEnabled())
+        TraceRecorder::GetInstance().Instant(name, arg_name, arg);
+}
+
+} // namespace vr
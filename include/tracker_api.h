@@ -4,8 +4,13 @@
 #include <memory>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
+#include <array>
+#include <vector>
+#include <cstring>
 #include <openvr_driver.h>
 #include "tracker_device_driver.h"
+#include "skeleton_solver.h"
 
 namespace vr {
 
@@ -15,6 +20,62 @@ struct DevicePose {
     bool is_valid;
 };
 
+// body trackers in a slot set, the name is what senders put in the serial field
+enum class TrackerRole : uint8_t {
+    Waist = 0,
+    LeftFoot,
+    RightFoot,
+    LeftKnee,
+    RightKnee,
+    LeftElbow,
+    RightElbow,
+    Chest,
+    Count
+};
+
+constexpr size_t kNumTrackerRoles = static_cast<size_t>(TrackerRole::Count);
+
+const char* GetTrackerRoleName(TrackerRole role);
+
+// match a 16 byte wire serial against the role names
+bool FindTrackerRole(const char* serial, TrackerRole& role);
+
+// 16 byte wire serial, zero padded, so ingest can look trackers up
+// without building strings
+struct SerialKey {
+    char bytes[16];
+
+    bool operator==(const SerialKey& other) const {
+        return memcmp(bytes, other.bytes, sizeof(bytes)) == 0;
+    }
+};
+
+struct SerialKeyHash {
+    size_t operator()(const SerialKey& key) const;
+};
+
+// false if the serial doesn't fit the wire field
+bool MakeSerialKey(const char* serial, SerialKey& key);
+
+// one body's worth of devices, owned by one sender session at a time
+struct TrackerSlotSet {
+    std::array<std::shared_ptr<class TrackerDeviceDriver>, kNumTrackerRoles> trackers;
+    std::atomic<uint32_t> owner{0};       // session id, 0 = free
+    std::atomic<int64_t> last_seen_ns{0}; // last owner update
+    std::atomic<uint32_t> write_seq{0};   // odd while a datagram is being applied
+    std::array<std::atomic<int64_t>, kNumTrackerRoles> role_seen_ns{}; // last pose from the sender per role
+    BodyProportions body;                 // fixed while ingest runs
+    std::atomic<int64_t> last_write_ns{0};       // receipt time of the last applied datagram
+    std::atomic<int64_t> last_capture_ns{0};     // its capture time in driver time, 0 = unknown
+    std::atomic<int64_t> publish_latency_ns{0};  // capture (or receipt) to publish, averaged
+    int64_t last_published_write_ns = 0;         // publisher only
+
+    DevicePose hmd_pose{};
+    DevicePose left_controller_pose{};
+    DevicePose right_controller_pose{};
+    mutable std::mutex poses_mutex;
+};
+
 class TrackerAPI {
 public:
     static TrackerAPI& GetInstance();
@@ -25,22 +86,80 @@ public:
     // unregister tracker
     void UnregisterTracker(const std::string& serial_number);
     
+    // find tracker
+    std::shared_ptr<class TrackerDeviceDriver> FindTracker(const std::string& serial_number);
+    std::shared_ptr<class TrackerDeviceDriver> FindTracker(const SerialKey& serial);
+
+    // bumped on register/unregister
+    uint64_t GetGeneration() const { return generation_.load(std::memory_order_acquire); }
+
     // update pose
     bool UpdateTrackerPose(const std::string& serial_number, 
                           const HmdVector3_t& position, 
                           const HmdQuaternion_t& rotation);
 
+    // update battery/charging/connection
+    bool UpdateTrackerStatus(const std::string& serial_number,
+                            float battery,
+                            bool charging,
+                            bool connected);
+
+    // add slot set, only while ingest is stopped
+    void RegisterSlotSet(const std::array<std::shared_ptr<class TrackerDeviceDriver>, kNumTrackerRoles>& trackers,
+                         const BodyProportions& body = BodyProportions());
+
+    // remove all slot sets, only while ingest is stopped
+    void ClearSlotSets();
+
+    size_t GetSlotSetCount() const { return slot_sets_.size(); }
+
+    // claim a free (or timed out) slot set for a session, -1 if none
+    int AcquireSlotSet(uint32_t session_id, int64_t now_ns, int64_t timeout_ns);
+
+    // refresh ownership, false if the set was taken over
+    bool TouchSlotSet(int set, uint32_t session_id, int64_t now_ns);
+
+    // hand set back and mark its trackers disconnected
+    void ReleaseSlotSet(int set, uint32_t session_id);
+
+    TrackerDeviceDriver* GetSlotTracker(int set, TrackerRole role) const;
+
+    // bracket one datagram's writes to a set, single writer (the owning worker)
+    void BeginSlotSetWrite(int set);
+    // capture_ns from a clock synced sender, 0 = unknown
+    void EndSlotSetWrite(int set, int64_t received_ns, int64_t capture_ns = 0);
+
+    // poses of the set went out, from the publishing thread
+    void RecordPublish(int set, int64_t now_ns);
+
+    // average age of a datagram's poses when first published, from
+    // capture when the sender's clock is synced, otherwise from receipt
+    int64_t GetPublishLatency(int set) const;
+
+    // derive knees, elbows and chest the sender doesn't stream
+    void SetDeriveTrackers(bool enabled) { derive_trackers_ = enabled; }
+    bool GetDeriveTrackers() const { return derive_trackers_.load(std::memory_order_relaxed); }
+
+    // role pose received from the set's sender
+    void MarkRoleSeen(int set, TrackerRole role, int64_t now_ns);
+
+    // solve derived roles from the set's anchors, by the owning worker
+    void SolveDerivedTrackers(int set, int64_t now_ns, int64_t capture_ns = 0);
+
+    // poses of every tracker in the set, all from the same datagram
+    void SnapshotSlotSet(int set, std::array<DriverPose_t, kNumTrackerRoles>& poses) const;
+
     // get hmd
-    DevicePose GetHMDPose() const;
+    DevicePose GetHMDPose(int set = 0) const;
     
     // get controller
-    DevicePose GetControllerPose(bool is_left) const;
+    DevicePose GetControllerPose(bool is_left, int set = 0) const;
     
     // update hmd
-    void UpdateHMDPose(const HmdVector3_t& position, const HmdQuaternion_t& rotation);
+    void UpdateHMDPose(const HmdVector3_t& position, const HmdQuaternion_t& rotation, int set = 0);
     
     // update controller
-    void UpdateControllerPose(bool is_left, const HmdVector3_t& position, const HmdQuaternion_t& rotation);
+    void UpdateControllerPose(bool is_left, const HmdVector3_t& position, const HmdQuaternion_t& rotation, int set = 0);
 
 private:
     TrackerAPI() = default;
@@ -49,12 +168,13 @@ private:
     TrackerAPI& operator=(const TrackerAPI&) = delete;
 
     std::unordered_map<std::string, std::shared_ptr<class TrackerDeviceDriver>> trackers_;
+    std::unordered_map<SerialKey, std::shared_ptr<class TrackerDeviceDriver>, SerialKeyHash> tracker_keys_; // serials that fit the wire
     std::mutex trackers_mutex_;
-    
-    DevicePose hmd_pose_{};
-    DevicePose left_controller_pose_{};
-    DevicePose right_controller_pose_{};
-    mutable std::mutex device_poses_mutex_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<bool> derive_trackers_{false};
+
+    // fixed while ingest runs, so lookups need no lock
+    std::vector<std::unique_ptr<TrackerSlotSet>> slot_sets_;
 };
 
 } // namespace vr 
\ No newline at end of file
@@ -6,6 +6,11 @@
 #include <thread>
 #include <mutex>
 #include "openvr_driver.h"
+#include "tracker_property_cache.h"
+
+namespace vr {
+class MyDeviceProvider;
+}
 
 enum TrackerComponent {
     TrackerComponent_trigger_value,
@@ -24,19 +29,49 @@ public:
     void DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) override;
     vr::DriverPose_t GetPose() override;
 
-    void UpdatePose(const vr::HmdVector3_t& position, const vr::HmdQuaternion_t& rotation);
+    const std::string& GetSerialNumber() const { return serial_number_; }
+
+    // capture_ns is when the sender sampled the pose in driver time, 0 = unknown
+    void UpdatePose(const vr::HmdVector3_t& position, const vr::HmdQuaternion_t& rotation, int64_t capture_ns = 0);
+    // battery and charging are properties and go through the cache.
+    // connected is pose state (deviceIsConnected), not a property, so it
+    // bypasses the cache and goes out with the next published pose
+    void UpdateStatus(float battery, bool charging, bool connected);
+    void SetConnected(bool connected);
     void RunFrame();
 
+    // hand a pose snapshot to vrserver
+    void PublishPose(const vr::DriverPose_t& pose);
+
+    // ingest ownership, a slot is written by one ingest worker at a time;
+    // another worker takes over once the owner has gone quiet
+    bool ClaimIngest(int worker_id, int64_t now_ns);
+    void ReleaseIngest(int worker_id);
+
 private:
+    // driver-wide standby from the provider: no publishing or property
+    // writes until resumed. vrserver's per-device EnterStandby (e.g. a
+    // tracker turned off in the dashboard) has no matching call, so it
+    // doesn't suspend anything
+    friend class vr::MyDeviceProvider;
+    void Suspend();
+    void Resume();
+
     std::string serial_number_;
     std::string model_number_;
     vr::ETrackedDeviceClass device_class_;
     std::atomic<vr::TrackedDeviceIndex_t> device_index_;
     std::atomic<bool> is_active_;
     std::atomic<bool> is_connected_;
-    
+    std::atomic<bool> is_standby_;
+    std::atomic<int> ingest_owner_;
+    std::atomic<int64_t> ingest_last_update_;
+    vr::PropertyContainerHandle_t property_container_;
+    TrackerPropertyCache property_cache_;
+
     std::array<vr::VRInputComponentHandle_t, TrackerComponent_MAX> input_handles_;
     
     vr::DriverPose_t current_pose_;
+    int64_t capture_ns_ = 0;
     std::mutex pose_mutex_;
 }; 
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace vr {
+
+struct PublisherStats {
+    uint64_t ticks = 0;          // publish passes
+    uint64_t late_ticks = 0;     // woke more than a period late
+    double rate_hz = 0.0;        // current tick rate
+    double mean_jitter_us = 0.0; // wake time past deadline
+    double max_jitter_us = 0.0;
+};
+
+// publishes every slot set in one pass, either from RunFrame or from its
+// own thread at a fixed rate so output timing doesn't follow input bursts
+class TrackerPosePublisher {
+public:
+    ~TrackerPosePublisher();
+
+    // follow_display tracks the hmd refresh rate, rate_hz until it is known
+    bool Start(double rate_hz, bool follow_display);
+    void Stop();
+    bool IsRunning() const { return running_; }
+    double GetRate() const { return rate_hz_; }
+
+    // standby parks the thread until woken, ticks restart from the wake
+    void SetStandby(bool standby);
+
+    // snapshot all slot sets and publish them
+    void PublishAll();
+
+    PublisherStats GetStats() const;
+
+    // stats of the running publisher thread, false if there is none
+    static bool GetRunningStats(PublisherStats& stats);
+
+private:
+    void Run();
+    double ReadDisplayFrequency() const;
+
+    std::unique_ptr<std::thread> thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> standby_{false};
+    std::mutex standby_mutex_;
+    std::condition_variable standby_cv_;
+    std::atomic<double> rate_hz_{90.0};
+    bool follow_display_ = false;
+
+    std::atomic<uint64_t> ticks_{0};
+    std::atomic<uint64_t> late_ticks_{0};
+    std::atomic<int64_t> jitter_sum_ns_{0};
+    std::atomic<int64_t> jitter_max_ns_{0};
+
+    static std::atomic<TrackerPosePublisher*> running_publisher_;
+};
+
+} // namespace vr
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "openvr_driver.h"
+
+// holds the intended value of each device property and writes only the
+// ones that changed since the last flush, in a single batched call
+class TrackerPropertyCache {
+public:
+    static constexpr size_t kMaxProperties = 16;
+
+    // set intended value, no-op if unchanged
+    void SetBool(vr::ETrackedDeviceProperty prop, bool value);
+    void SetFloat(vr::ETrackedDeviceProperty prop, float value);
+    void SetInt32(vr::ETrackedDeviceProperty prop, int32_t value);
+    void SetString(vr::ETrackedDeviceProperty prop, const std::string& value);
+
+    // mark all values dirty (e.g. on activate)
+    void Invalidate();
+
+    // write dirty values, returns count written
+    uint32_t Flush(vr::PropertyContainerHandle_t container);
+
+private:
+    struct Entry {
+        vr::ETrackedDeviceProperty prop = vr::Prop_Invalid;
+        vr::PropertyTypeTag_t tag = vr::k_unInvalidPropertyTag;
+        union {
+            bool b;
+            float f;
+            int32_t i;
+        } value{};
+        std::string str;
+        bool dirty = false;
+    };
+
+    Entry* FindOrAdd(vr::ETrackedDeviceProperty prop, vr::PropertyTypeTag_t tag);
+
+    std::array<Entry, kMaxProperties> entries_;
+    size_t count_ = 0;
+    std::atomic<bool> dirty_{false};
+    std::mutex mutex_;
+};
@@ -1,8 +1,17 @@
 #pragma once
 
+#include <array>
 #include <thread>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <memory>
+#include <vector>
+#include "sender_session_table.h"
+#include "tracker_api.h"
+
+class TrackerDeviceDriver;
 
 namespace vr {
 
@@ -13,6 +22,29 @@ enum class DeviceType : uint8_t {
     RightController = 3
 };
 
+// non-pose message marker (first byte)
+enum class PacketType : uint8_t {
+    Status = 0xF0,
+    Feedback = 0xF1,  // driver -> sender
+    ClockPing = 0xF2, // driver -> sender
+    ClockEcho = 0xF3  // sender -> driver
+};
+
+enum StatusFlags : uint8_t {
+    StatusFlag_Charging = 1 << 0,
+    StatusFlag_Connected = 1 << 1
+};
+
+// UdpFeedbackPacket::needed_devices, roles use bit 1 << role
+enum FeedbackDevices : uint16_t {
+    FeedbackDevice_HMD = 1 << 8,
+    FeedbackDevice_LeftController = 1 << 9,
+    FeedbackDevice_RightController = 1 << 10
+};
+
+// role bits sit below FeedbackDevice_HMD
+static_assert(kNumTrackerRoles <= 8, "tracker role bits would alias FeedbackDevices");
+
 #pragma pack(push, 1)
 struct UdpPosePacket {
     DeviceType device_type;  // device type
@@ -25,21 +57,132 @@ struct UdpBatchPacket {
     uint8_t num_devices;    // device count
     UdpPosePacket devices[8]; // device batch
 };
+
+struct UdpStatusPacket {
+    PacketType packet_type; // PacketType::Status
+    char serial[16];        // device serial
+    float battery;          // battery 0..1
+    uint8_t flags;          // StatusFlags
+};
+
+// sent back to each active sender, a batch may end in a uint32 sequence
+// number so loss can be measured, optionally followed by an int64 capture
+// time on the sender's clock
+struct UdpFeedbackPacket {
+    PacketType packet_type;  // PacketType::Feedback
+    float desired_rate_hz;   // rate poses are published at
+    float loss;              // lost datagrams since last feedback 0..1, -1 unknown
+    float latency_ms;        // receipt to publish, averaged
+    uint16_t needed_devices; // FeedbackDevices and role bits
+    uint32_t received;       // datagrams received from this sender
+};
+
+// clock sync round trip, the sender echoes each ping right away
+struct UdpClockPingPacket {
+    PacketType packet_type;  // PacketType::ClockPing
+    int64_t driver_send_ns;  // driver clock
+};
+
+struct UdpClockEchoPacket {
+    PacketType packet_type;  // PacketType::ClockEcho
+    int64_t driver_send_ns;  // copied from the ping
+    int64_t sender_recv_ns;  // sender clock
+    int64_t sender_send_ns;
+};
 #pragma pack(pop)
 
+struct IngestStats {
+    uint64_t datagrams = 0; // datagrams received
+    uint64_t updates = 0;   // device updates applied
+    uint64_t dropped = 0;   // updates without a slot this worker owns
+};
+
 class TrackerUDPServer {
 public:
     static TrackerUDPServer& GetInstance();
-    bool Start(int port = 9000);
+
+    // num_workers > 1 shards ingest across threads, each with its own
+    // socket: SO_REUSEPORT on the same port where available, otherwise
+    // one port per worker (port .. port + num_workers - 1).
+    // each sender address gets its own slot set from TrackerAPI, released
+    // after session_timeout_ms without datagrams
+    bool Start(int port = 9000, int num_workers = 1, int session_timeout_ms = 3000);
     void Stop();
+    IngestStats GetStats() const;
+
+    // receive a multicast group (ipv4 or ipv6) besides unicast, set before
+    // Start. empty listens dual-stack on unicast only
+    void SetMulticastGroup(const std::string& group) { multicast_group_ = group; }
+
+    // feedback to senders
+    void SetFeedbackEnabled(bool enabled) { feedback_enabled_ = enabled; }
+    void SetDesiredRate(float hz) { desired_rate_hz_.store(hz, std::memory_order_relaxed); }
+
+    // ping senders to map their capture times into driver time
+    void SetClockSyncEnabled(bool enabled) { clock_sync_enabled_ = enabled; }
+
+    // standby: workers drop to idle priority and handle datagrams in
+    // bursts a few times a second, senders are asked for a low rate.
+    // each burst applies only the newest poses of every sender, and
+    // leaving waits for the datagrams queued since, so nothing jumps on wake
+    void SetStandby(bool standby);
+    bool IsStandby() const { return standby_.load(std::memory_order_relaxed); }
     ~TrackerUDPServer();
 private:
+    // tracker cached for a serial outside the slot sets, tracker null = empty
+    struct SerialSlot {
+        SerialKey key{};
+        std::shared_ptr<TrackerDeviceDriver> tracker;
+    };
+    // open addressing, entries are only cleared all at once; twice the
+    // number of devices vrserver can hold, so it never fills up
+    static constexpr size_t kSerialSlotCapacity = 128;
+    static_assert((kSerialSlotCapacity & (kSerialSlotCapacity - 1)) == 0, "probing masks the hash");
+
+    // per-thread ingest state, only touched by its own thread
+    struct alignas(64) IngestWorker {
+        int id = 0;
+        int port = 0;
+        int family = 0;       // AF_INET6 dual-stack, AF_INET without ipv6 or for an ipv4 group
+        std::unique_ptr<std::thread> thread;
+        std::array<SerialSlot, kSerialSlotCapacity> slots{}; // fixed, lookups never allocate
+        size_t num_slots = 0;
+        uint64_t registry_generation = 0;
+        SenderSessionTable sessions;
+        int64_t last_sweep_ns = 0;
+        int64_t last_backchannel_ns = 0;
+        std::atomic<bool> waking{false}; // parked in standby, queue not drained since
+        std::atomic<uint64_t> datagrams{0};
+        std::atomic<uint64_t> updates{0};
+        std::atomic<uint64_t> dropped{0};
+    };
+
     TrackerUDPServer();
-    void RunServer();
-    void HandlePosePacket(const UdpPosePacket& packet);
-    std::unique_ptr<std::thread> server_thread_;
+    void RunServer(IngestWorker& worker);
+    SenderSession* UpdateSession(IngestWorker& worker, const SenderKey& key, int64_t now);
+    void ExpireSessions(IngestWorker& worker, int64_t now, bool expire_all);
+    void HandlePoseDatagram(IngestWorker& worker, SenderSession* session, const char* buffer, size_t size, int64_t now);
+    void ApplyStandbyDatagrams(IngestWorker& worker);
+    void HandlePosePacket(IngestWorker& worker, int set, const UdpPosePacket& packet, int64_t now, int64_t capture_ns);
+    void HandleStatusPacket(IngestWorker& worker, int set, const UdpStatusPacket& packet, int64_t now);
+    // role is set to the slot set role the serial named, TrackerRole::Count if none
+    TrackerDeviceDriver* ResolveTracker(IngestWorker& worker, int set, const char* serial, int64_t now, TrackerRole& role);
+    void ReleaseSlots(IngestWorker& worker);
+    void UpdateSequence(SenderSession& session, uint32_t sequence);
+    void SendFeedback(IngestWorker& worker, int sockfd, int64_t now);
+    void SendClockPings(IngestWorker& worker, int sockfd, int64_t now);
+    void HandleClockEcho(SenderSession& session, const UdpClockEchoPacket& packet, int64_t now);
+    std::vector<std::unique_ptr<IngestWorker>> workers_;
     std::atomic<bool> running_{false};
     int port_ = 9000;
+    std::string multicast_group_;
+    int64_t session_timeout_ns_ = 0;
+    std::atomic<bool> feedback_enabled_{true};
+    std::atomic<bool> clock_sync_enabled_{true};
+    std::atomic<bool> standby_{false};
+    std::mutex standby_mutex_;
+    std::condition_variable standby_cv_;
+    std::atomic<float> desired_rate_hz_{0.0f};
 };
 
 } // namespace vr 
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "clock_sync.h"
+#include <algorithm>
+
+namespace vr {
+
+namespace {
+
+// share of the error taken into offset and drift per selected round trip
+constexpr double kOffsetGain = 0.5;
+constexpr double kDriftGain = 0.1;
+
+// crystals are well within this
+constexpr double kMaxDrift = 500e-6;
+
+// drift is held at 0 until the estimate spans this long, and only
+// corrected across round trips at least this far apart, so round trip
+// jitter over the fast initial pings can't pass for drift
+constexpr int64_t kDriftSpanNs = 4000000000;
+constexpr int64_t kDriftMinElapsedNs = 500000000;
+
+} // namespace
+
+void ClockSync::AddSample(int64_t driver_send_ns, int64_t sender_recv_ns, int64_t sender_send_ns, int64_t driver_recv_ns) {
+    Sample sample;
+    sample.driver_ns = driver_send_ns + (driver_recv_ns - driver_send_ns) / 2;
+    sample.offset_ns = ((sender_recv_ns - driver_send_ns) + (sender_send_ns - driver_recv_ns)) / 2;
+    // negative with a coarse sender clock
+    sample.delay_ns = std::max<int64_t>(0, (driver_recv_ns - driver_send_ns) - (sender_send_ns - sender_recv_ns));
+    window_[samples_ % kWindow] = sample;
+    ++samples_;
+
+    // clock filter, a selected round trip is used once
+    size_t count = std::min<size_t>(samples_, kWindow);
+    const Sample* best = &window_[0];
+    for (size_t i = 1; i < count; ++i) {
+        if (window_[i].delay_ns < best->delay_ns) best = &window_[i];
+    }
+    if (best->driver_ns <= ref_ns_)
+        return;
+
+    if (ref_ns_ == 0) {
+        offset_ns_ = static_cast<double>(best->offset_ns);
+        ref_ns_ = best->driver_ns;
+        first_ref_ns_ = best->driver_ns;
+        return;
+    }
+
+    // predict from the last estimate, then correct offset and drift
+    double elapsed = static_cast<double>(best->driver_ns - ref_ns_);
+    double predicted = offset_ns_ + drift_ * elapsed;
+    double error = best->offset_ns - predicted;
+    offset_ns_ = predicted + kOffsetGain * error;
+    if (best->driver_ns - first_ref_ns_ >= kDriftSpanNs && elapsed >= kDriftMinElapsedNs) {
+        drift_ = std::clamp(drift_ + kDriftGain * error / elapsed, -kMaxDrift, kMaxDrift);
+    }
+    ref_ns_ = best->driver_ns;
+}
+
+int64_t ClockSync::ToDriverTime(int64_t sender_ns) const {
+    // first order inverse of sender = driver + offset + drift * (driver - ref)
+    double driver = static_cast<double>(sender_ns) - offset_ns_;
+    driver -= drift_ * (driver - static_cast<double>(ref_ns_));
+    return static_cast<int64_t>(driver);
+}
+
+int64_t ClockSync::GetRoundTripNs() const {
+    size_t count = std::min<size_t>(samples_, kWindow);
+    int64_t best = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (i == 0 || window_[i].delay_ns < best) best = window_[i].delay_ns;
+    }
+    return best;
+}
+
+} // namespace vr
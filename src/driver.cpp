@@ -3,7 +3,12 @@
 #include "tracker_device_driver.h"
 #include "tracker_api.h"
 #include "tracker_udp_server.h"
+#include "driver_settings.h"
+#include "trace_recorder.h"
+#include <chrono>
 #include <memory>
+#include <array>
+#include <string>
 #include <iostream>
 #include <cstring>
 
@@ -13,66 +18,100 @@
 
 namespace vr {
 
-MyDeviceProvider::MyDeviceProvider() {
-    if (!TrackerUDPServer::GetInstance().Start()) {
-        std::cerr << "Failed to start UDP tracker server" << std::endl;
-    }
-}
+MyDeviceProvider::MyDeviceProvider() {}
 
+// the ingest server stops in Cleanup() and with its own singleton
 MyDeviceProvider::~MyDeviceProvider() {
-    TrackerUDPServer::GetInstance().Stop();
+    publisher_.Stop();
 }
 
 EVRInitError MyDeviceProvider::Init(IVRDriverContext* pDriverContext) {
     VR_INIT_SERVER_DRIVER_CONTEXT(pDriverContext);
 
-    auto waist_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_Waist", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto left_foot_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_LeftFoot", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto right_foot_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_RightFoot", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto left_knee_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_LeftKnee", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto right_knee_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_RightKnee", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto left_elbow_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_LeftElbow", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto right_elbow_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_RightElbow", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-    auto chest_tracker = std::make_shared<TrackerDeviceDriver>("OpenTrackServer_Chest", "OpenTrackServer", TrackedDeviceClass_GenericTracker);
-
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_Waist", waist_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_LeftFoot", left_foot_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_RightFoot", right_foot_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_LeftKnee", left_knee_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_RightKnee", right_knee_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_LeftElbow", left_elbow_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_RightElbow", right_elbow_tracker);
-    TrackerAPI::GetInstance().RegisterTracker("OpenTrackServer_Chest", chest_tracker);
-
-    trackers_.push_back(waist_tracker);
-    trackers_.push_back(left_foot_tracker);
-    trackers_.push_back(right_foot_tracker);
-    trackers_.push_back(left_knee_tracker);
-    trackers_.push_back(right_knee_tracker);
-    trackers_.push_back(left_elbow_tracker);
-    trackers_.push_back(right_elbow_tracker);
-    trackers_.push_back(chest_tracker);
+    DriverSettings settings = DriverSettings::Load();
+
+    // opt-in tracing, before any thread records
+    if (settings.trace_events > 0) {
+        TraceRecorder::GetInstance().Enable(settings.trace_events, settings.trace_path);
+        TraceRecorder::GetInstance().SetThreadName("driver");
+    }
+
+    // one slot set of body trackers per concurrent sender,
+    // set 0 keeps the plain serials
+    for (int set = 0; set < settings.max_senders; ++set) {
+        std::array<std::shared_ptr<TrackerDeviceDriver>, kNumTrackerRoles> slot_trackers;
+        for (size_t role = 0; role < kNumTrackerRoles; ++role) {
+            std::string serial = std::string("OpenTrackServer_") + GetTrackerRoleName(static_cast<TrackerRole>(role));
+            if (set > 0) {
+                serial += "_" + std::to_string(set);
+            }
+            auto tracker = std::make_shared<TrackerDeviceDriver>(serial, "OpenTrackServer", TrackedDeviceClass_GenericTracker);
+            TrackerAPI::GetInstance().RegisterTracker(serial, tracker);
+            slot_trackers[role] = tracker;
+            trackers_.push_back(tracker);
+            VRServerDriverHost()->TrackedDeviceAdded(serial.c_str(), TrackedDeviceClass_GenericTracker, tracker.get());
+        }
+        TrackerAPI::GetInstance().RegisterSlotSet(slot_trackers, settings.bodies[set]);
+    }
+    TrackerAPI::GetInstance().SetDeriveTrackers(settings.derive_trackers);
+
+    // start ingest
+    TrackerUDPServer::GetInstance().SetMulticastGroup(settings.multicast_group);
+    TrackerUDPServer::GetInstance().SetFeedbackEnabled(settings.sender_feedback);
+    TrackerUDPServer::GetInstance().SetClockSyncEnabled(settings.clock_sync);
+    if (!TrackerUDPServer::GetInstance().Start(settings.port, settings.ingest_workers, settings.session_timeout_ms)) {
+        std::cerr << "Failed to start UDP tracker server" << std::endl;
+    }
+
+    // fixed rate publishing, otherwise poses go out with RunFrame
+    if (settings.publish_rate_hz > 0 || settings.publish_follow_display) {
+        publisher_.Start(settings.publish_rate_hz, settings.publish_follow_display);
+    }
 
     return VRInitError_None;
 }
 
 void MyDeviceProvider::Cleanup() {
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_Waist");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_LeftFoot");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_RightFoot");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_LeftKnee");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_RightKnee");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_LeftElbow");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_RightElbow");
-    TrackerAPI::GetInstance().UnregisterTracker("OpenTrackServer_Chest");
+    publisher_.Stop();
+    TrackerUDPServer::GetInstance().Stop();
+
+    if (TraceRecorder::IsEnabled()) {
+        TraceRecorder::GetInstance().WriteChromeTrace();
+        TraceRecorder::GetInstance().Enable(0, std::string());
+    }
+
+    TrackerAPI::GetInstance().ClearSlotSets();
+    for (auto& tracker : trackers_) {
+        TrackerAPI::GetInstance().UnregisterTracker(tracker->GetSerialNumber());
+    }
 
     trackers_.clear();
 }
 
 void MyDeviceProvider::RunFrame() {
+    if (standby_)
+        return;
+
+    TraceScope trace("RunFrame");
+
     for (auto& tracker : trackers_) {
         tracker->RunFrame();
     }
+
+    if (!publisher_.IsRunning()) {
+        publisher_.PublishAll();
+    }
+
+    // rate senders are asked for
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    if (last_frame_ns_ != 0 && now > last_frame_ns_) {
+        double rate = 1e9 / (now - last_frame_ns_);
+        frame_rate_hz_ = frame_rate_hz_ == 0.0 ? rate : frame_rate_hz_ + (rate - frame_rate_hz_) * 0.05;
+    }
+    last_frame_ns_ = now;
+    TrackerUDPServer::GetInstance().SetDesiredRate(
+        static_cast<float>(publisher_.IsRunning() ? publisher_.GetRate() : frame_rate_hz_));
 }
 
 const char* const* MyDeviceProvider::GetInterfaceVersions() {
@@ -83,15 +122,43 @@ bool MyDeviceProvider::ShouldBlockStandbyMode() {
     return false;
 }
 
-void MyDeviceProvider::EnterStandby() {}
+void MyDeviceProvider::EnterStandby() {
+    if (standby_)
+        return;
+    standby_ = true;
+    std::cout << "Entering standby" << std::endl;
 
-void MyDeviceProvider::LeaveStandby() {}
+    publisher_.SetStandby(true);
+    for (auto& tracker : trackers_) {
+        tracker->Suspend();
+    }
+    TrackerUDPServer::GetInstance().SetStandby(true);
+}
+
+void MyDeviceProvider::LeaveStandby() {
+    if (!standby_)
+        return;
+    standby_ = false;
+    std::cout << "Leaving standby" << std::endl;
+
+    // ingest first, then devices, so the first publish is current
+    TrackerUDPServer::GetInstance().SetStandby(false);
+    for (auto& tracker : trackers_) {
+        tracker->Resume();
+    }
+    publisher_.SetStandby(false);
+
+    // frame rate restarts from the next frame
+    last_frame_ns_ = 0;
+}
 
 } // namespace vr
 
 extern "C" DRIVER_EXPORT void* HmdDriverFactory(const char* pInterfaceName, int* pReturnCode) {
     if (0 == strcmp(vr::IServerTrackedDeviceProvider_Version, pInterfaceName)) {
-        return new vr::MyDeviceProvider();
+        // one provider per library, torn down with it
+        static vr::MyDeviceProvider provider;
+        return &provider;
     }
 
     if (pReturnCode) {
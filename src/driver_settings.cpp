@@ -0,0 +1,88 @@
+#include "driver_settings.h"
+#include <openvr_driver.h>
+
+namespace vr {
+
+namespace {
+
+void ReadInt(IVRSettings* settings, const char* key, int& value) {
+    EVRSettingsError error = VRSettingsError_None;
+    int32_t result = settings->GetInt32(k_pchSettingsSection, key, &error);
+    if (error == VRSettingsError_None && result > 0) {
+        value = result;
+    }
+}
+
+void ReadFloat(IVRSettings* settings, const std::string& key, float& value) {
+    EVRSettingsError error = VRSettingsError_None;
+    float result = settings->GetFloat(k_pchSettingsSection, key.c_str(), &error);
+    if (error == VRSettingsError_None && result > 0.0f) {
+        value = result;
+    }
+}
+
+// userHeight rescales all proportions, bone lengths override single segments
+BodyProportions ReadBody(IVRSettings* settings, const std::string& suffix, const BodyProportions& defaults) {
+    BodyProportions body = defaults;
+    float height = 0.0f;
+    ReadFloat(settings, "userHeight" + suffix, height);
+    if (height > 0.0f) {
+        body = BodyProportions::FromHeight(height);
+    }
+    ReadFloat(settings, "thighLength" + suffix, body.thigh);
+    ReadFloat(settings, "shinLength" + suffix, body.shin);
+    ReadFloat(settings, "upperArmLength" + suffix, body.upper_arm);
+    ReadFloat(settings, "forearmLength" + suffix, body.forearm);
+    return body;
+}
+
+void ReadBool(IVRSettings* settings, const char* key, bool& value) {
+    EVRSettingsError error = VRSettingsError_None;
+    bool result = settings->GetBool(k_pchSettingsSection, key, &error);
+    if (error == VRSettingsError_None) {
+        value = result;
+    }
+}
+
+void ReadString(IVRSettings* settings, const char* key, std::string& value) {
+    EVRSettingsError error = VRSettingsError_None;
+    char result[1024] = {};
+    settings->GetString(k_pchSettingsSection, key, result, sizeof(result), &error);
+    if (error == VRSettingsError_None && result[0] != '\0') {
+        value = result;
+    }
+}
+
+} // namespace
+
+DriverSettings DriverSettings::Load() {
+    DriverSettings result;
+    IVRSettings* settings = VRSettings();
+    if (!settings) {
+        result.bodies.assign(result.max_senders, BodyProportions());
+        return result;
+    }
+
+    ReadInt(settings, "port", result.port);
+    ReadInt(settings, "ingestWorkers", result.ingest_workers);
+    ReadString(settings, "multicastGroup", result.multicast_group);
+    ReadInt(settings, "maxSenders", result.max_senders);
+    ReadInt(settings, "sessionTimeoutMs", result.session_timeout_ms);
+    ReadInt(settings, "publishRateHz", result.publish_rate_hz);
+    ReadBool(settings, "publishFollowDisplay", result.publish_follow_display);
+    ReadInt(settings, "traceEvents", result.trace_events);
+    ReadString(settings, "tracePath", result.trace_path);
+    ReadBool(settings, "senderFeedback", result.sender_feedback);
+    ReadBool(settings, "clockSync", result.clock_sync);
+    ReadBool(settings, "deriveTrackers", result.derive_trackers);
+
+    // set 0 reads the plain keys, the others fall back to set 0
+    BodyProportions body = ReadBody(settings, "", BodyProportions());
+    result.bodies.push_back(body);
+    for (int set = 1; set < result.max_senders; ++set) {
+        result.bodies.push_back(ReadBody(settings, "_" + std::to_string(set), body));
+    }
+    return result;
+}
+
+} // namespace vr
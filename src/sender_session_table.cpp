@@ -0,0 +1,73 @@
+#include "sender_session_table.h"
+
+namespace vr {
+
+SenderKey MakeSenderKey(uint32_t ipv4_addr, uint16_t port) {
+    SenderKey key{};
+    key.addr[10] = 0xff;
+    key.addr[11] = 0xff;
+    memcpy(&key.addr[12], &ipv4_addr, sizeof(ipv4_addr));
+    key.port = port;
+    return key;
+}
+
+SenderKey MakeSenderKey(const uint8_t ipv6_addr[16], uint16_t port) {
+    SenderKey key{};
+    memcpy(key.addr, ipv6_addr, sizeof(key.addr));
+    key.port = port;
+    return key;
+}
+
+size_t SenderSessionTable::Hash(const SenderKey& key) {
+    // fnv-1a
+    uint32_t hash = 2166136261u;
+    for (uint8_t byte : key.addr) {
+        hash = (hash ^ byte) * 16777619u;
+    }
+    hash = (hash ^ (key.port & 0xff)) * 16777619u;
+    hash = (hash ^ (key.port >> 8)) * 16777619u;
+    return hash & (kCapacity - 1);
+}
+
+SenderSession* SenderSessionTable::Find(const SenderKey& key) {
+    for (size_t i = Hash(key), probes = 0; probes < kCapacity; i = (i + 1) & (kCapacity - 1), ++probes) {
+        if (entries_[i].id == 0)
+            return nullptr;
+        if (entries_[i].key == key)
+            return &entries_[i];
+    }
+    return nullptr;
+}
+
+SenderSession* SenderSessionTable::Insert(const SenderKey& key, uint32_t id) {
+    if (size_ >= kMaxSessions)
+        return nullptr;
+    size_t i = Hash(key);
+    while (entries_[i].id != 0) {
+        i = (i + 1) & (kCapacity - 1);
+    }
+    entries_[i] = SenderSession{};
+    entries_[i].key = key;
+    entries_[i].id = id;
+    ++size_;
+    return &entries_[i];
+}
+
+void SenderSessionTable::EraseAt(size_t index) {
+    // backward shift deletion keeps probe chains intact without tombstones
+    size_t hole = index;
+    size_t next = (hole + 1) & (kCapacity - 1);
+    while (entries_[next].id != 0) {
+        size_t home = Hash(entries_[next].key);
+        // distance from home, entry can move into the hole if it isn't past it
+        if (((next - home) & (kCapacity - 1)) >= ((next - hole) & (kCapacity - 1))) {
+            entries_[hole] = entries_[next];
+            hole = next;
+        }
+        next = (next + 1) & (kCapacity - 1);
+    }
+    entries_[hole] = SenderSession{};
+    --size_;
+}
+
+} // namespace vr
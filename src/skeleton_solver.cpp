@@ -0,0 +1,157 @@
+#include "skeleton_solver.h"
+#include <algorithm>
+#include <cmath>
+
+namespace vr {
+
+namespace {
+
+// openvr space: +x right, +y up, -z forward
+
+struct Vec3 {
+    double x, y, z;
+};
+
+Vec3 operator+(const Vec3& a, const Vec3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 operator-(const Vec3& a, const Vec3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator*(const Vec3& a, double s) { return {a.x * s, a.y * s, a.z * s}; }
+
+double Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+Vec3 Cross(const Vec3& a, const Vec3& b) {
+    return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+double Length(const Vec3& a) { return std::sqrt(Dot(a, a)); }
+
+// fallback when a is degenerate
+Vec3 Normalize(const Vec3& a, const Vec3& fallback) {
+    double length = Length(a);
+    return length > 1e-6 ? a * (1.0 / length) : fallback;
+}
+
+Vec3 ToVec3(const HmdVector3_t& v) { return {v.v[0], v.v[1], v.v[2]}; }
+
+HmdVector3_t ToHmd(const Vec3& v) {
+    return {static_cast<float>(v.x), static_cast<float>(v.y), static_cast<float>(v.z)};
+}
+
+Vec3 Rotate(const HmdQuaternion_t& q, const Vec3& v) {
+    // v + 2w(u x v) + 2u x (u x v)
+    Vec3 u{q.x, q.y, q.z};
+    Vec3 t = Cross(u, v) * 2.0;
+    return v + t * q.w + Cross(u, t);
+}
+
+// rotation whose -z is forward and +y is up, forward is made orthogonal to up
+HmdQuaternion_t LookRotation(const Vec3& forward, const Vec3& up) {
+    Vec3 y = Normalize(up, {0, 1, 0});
+    Vec3 z = Normalize(forward * -1.0 - y * Dot(forward * -1.0, y), {0, 0, 1});
+    if (std::fabs(Dot(z, y)) > 0.999) {
+        z = Normalize(Cross({1, 0, 0}, y), {0, 0, 1});
+    }
+    Vec3 x = Cross(y, z);
+
+    // rotation matrix columns x, y, z to quaternion
+    HmdQuaternion_t q;
+    double trace = x.x + y.y + z.z;
+    if (trace > 0.0) {
+        double s = std::sqrt(trace + 1.0) * 2.0;
+        q.w = 0.25 * s;
+        q.x = (y.z - z.y) / s;
+        q.y = (z.x - x.z) / s;
+        q.z = (x.y - y.x) / s;
+    } else if (x.x > y.y && x.x > z.z) {
+        double s = std::sqrt(1.0 + x.x - y.y - z.z) * 2.0;
+        q.w = (y.z - z.y) / s;
+        q.x = 0.25 * s;
+        q.y = (y.x + x.y) / s;
+        q.z = (z.x + x.z) / s;
+    } else if (y.y > z.z) {
+        double s = std::sqrt(1.0 + y.y - x.x - z.z) * 2.0;
+        q.w = (z.x - x.z) / s;
+        q.x = (y.x + x.y) / s;
+        q.y = 0.25 * s;
+        q.z = (z.y + y.z) / s;
+    } else {
+        double s = std::sqrt(1.0 + z.z - x.x - y.y) * 2.0;
+        q.w = (x.y - y.x) / s;
+        q.x = (z.x + x.z) / s;
+        q.y = (z.y + y.z) / s;
+        q.z = 0.25 * s;
+    }
+    return q;
+}
+
+// middle joint of a chain root -> end with bone lengths a, b, bent towards pole
+Vec3 SolveTwoBone(const Vec3& root, const Vec3& end, const Vec3& pole, double a, double b) {
+    Vec3 dir = Normalize(end - root, {0, -1, 0});
+    // keep the triangle valid when the end is out of (or too far in) reach
+    double distance = std::clamp(Length(end - root), std::fabs(a - b) + 1e-4, a + b - 1e-4);
+    double along = (distance * distance + a * a - b * b) / (2.0 * distance);
+    double height = std::sqrt(std::max(0.0, a * a - along * along));
+
+    Vec3 bend = pole - dir * Dot(pole, dir);
+    bend = Normalize(bend, Normalize(Cross(dir, {1, 0, 0}), {0, 0, -1}));
+    return root + dir * along + bend * height;
+}
+
+} // namespace
+
+BodyProportions BodyProportions::FromHeight(float height) {
+    BodyProportions body;
+    body.thigh = 0.245f * height;
+    body.shin = 0.246f * height;
+    body.upper_arm = 0.186f * height;
+    body.forearm = 0.16f * height;
+    body.hip_width = 0.1f * height;
+    body.shoulder_width = 0.2f * height;
+    body.hip_to_chest = 0.19f * height;
+    body.chest_to_shoulder = 0.06f * height;
+    body.neck_drop = 0.11f * height;
+    body.neck_back = 0.05f * height;
+    return body;
+}
+
+JointPose SolveChest(const BodyProportions& body, const JointPose& hip, const JointPose& head) {
+    Vec3 hip_pos = ToVec3(hip.position);
+    Vec3 neck = ToVec3(head.position) + Rotate(head.rotation, {0, -body.neck_drop, body.neck_back});
+
+    Vec3 spine = neck - hip_pos;
+    Vec3 up = Normalize(spine, {0, 1, 0});
+    Vec3 chest = hip_pos + up * std::min<double>(body.hip_to_chest, Length(spine));
+
+    // face between hips and head
+    Vec3 forward = Rotate(hip.rotation, {0, 0, -1}) + Rotate(head.rotation, {0, 0, -1});
+    return {ToHmd(chest), LookRotation(forward, up)};
+}
+
+JointPose SolveKnee(const BodyProportions& body, const JointPose& hip, const JointPose& foot, bool left) {
+    double side = left ? -0.5 : 0.5;
+    Vec3 hip_joint = ToVec3(hip.position) + Rotate(hip.rotation, {side * body.hip_width, 0, 0});
+    Vec3 foot_pos = ToVec3(foot.position);
+
+    Vec3 pole = Rotate(hip.rotation, {0, 0, -1}) + Rotate(foot.rotation, {0, 0, -1});
+    Vec3 knee = SolveTwoBone(hip_joint, foot_pos, pole, body.thigh, body.shin);
+
+    // tracker sits on the front of the thigh
+    Vec3 thigh = hip_joint - knee;
+    return {ToHmd(knee), LookRotation(pole, thigh)};
+}
+
+JointPose SolveElbow(const BodyProportions& body, const JointPose& chest, const JointPose& hand, bool left) {
+    double side = left ? -0.5 : 0.5;
+    Vec3 shoulder = ToVec3(chest.position) +
+                    Rotate(chest.rotation, {side * body.shoulder_width, body.chest_to_shoulder, 0});
+    Vec3 hand_pos = ToVec3(hand.position);
+
+    // down, back and a little outwards
+    Vec3 pole = Rotate(chest.rotation, {side, -2.0, 1.0});
+    Vec3 elbow = SolveTwoBone(shoulder, hand_pos, pole, body.upper_arm, body.forearm);
+
+    // tracker sits on the back of the upper arm
+    Vec3 upper_arm = shoulder - elbow;
+    return {ToHmd(elbow), LookRotation(pole * -1.0, upper_arm)};
+}
+
+} // namespace vr
@@ -0,0 +1,185 @@
+#include "trace_recorder.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+namespace vr {
+
+namespace {
+
+// threads beyond this don't get a ring
+constexpr size_t kMaxTraceThreads = 64;
+
+struct ThreadSlot {
+    void* buffer = nullptr;
+    uint64_t epoch = 0;
+};
+
+thread_local ThreadSlot t_slot;
+
+// json string contents
+std::string JsonEscape(const char* text) {
+    std::string escaped;
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            escaped += '\\';
+            escaped += *c;
+        } else if (static_cast<unsigned char>(*c) < 0x20) {
+            char code[8];
+            std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(*c));
+            escaped += code;
+        } else {
+            escaped += *c;
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+std::atomic<bool> TraceRecorder::enabled_{false};
+
+TraceRecorder& TraceRecorder::GetInstance() {
+    static TraceRecorder instance;
+    return instance;
+}
+
+int64_t TraceRecorder::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TraceRecorder::Enable(size_t events_per_thread, const std::string& path) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    enabled_ = false;
+    if (events_per_thread == 0)
+        return;
+
+    // fresh rings, threads notice the epoch change on their next event
+    buffers_.clear();
+    epoch_.fetch_add(1, std::memory_order_release);
+    events_per_thread_ = events_per_thread;
+    path_ = path;
+    start_ns_ = Now();
+    enabled_ = true;
+    if (path_.empty()) {
+        std::cerr << "Trace recording without a trace path, only a trace_dump request with a path saves it" << std::endl;
+    }
+}
+
+TraceRecorder::ThreadBuffer* TraceRecorder::GetThreadBuffer() {
+    uint64_t epoch = epoch_.load(std::memory_order_acquire);
+    if (t_slot.epoch == epoch)
+        return static_cast<ThreadBuffer*>(t_slot.buffer);
+
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    t_slot.epoch = epoch;
+    t_slot.buffer = nullptr;
+    if (buffers_.size() < kMaxTraceThreads) {
+        buffers_.push_back(std::make_unique<ThreadBuffer>(events_per_thread_, static_cast<uint32_t>(buffers_.size() + 1)));
+        t_slot.buffer = buffers_.back().get();
+    }
+    return static_cast<ThreadBuffer*>(t_slot.buffer);
+}
+
+void TraceRecorder::SetThreadName(const std::string& name) {
+    if (!IsEnabled())
+        return;
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+        return;
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffer->name = name;
+}
+
+void TraceRecorder::Instant(const char* name, const char* arg_name, int64_t arg) {
+    Record(name, Now(), -1, arg_name, arg);
+}
+
+void TraceRecorder::Complete(const char* name, int64_t start_ns, const char* arg_name, int64_t arg) {
+    Record(name, start_ns, Now() - start_ns, arg_name, arg);
+}
+
+void TraceRecorder::Record(const char* name, int64_t ts_ns, int64_t dur_ns, const char* arg_name, int64_t arg) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    if (!buffer)
+        return;
+
+    // single writer, the head store publishes the slot
+    uint64_t head = buffer->head.load(std::memory_order_relaxed);
+    Event& event = buffer->events[head % buffer->capacity];
+    event.ts_ns.store(ts_ns, std::memory_order_relaxed);
+    event.dur_ns.store(dur_ns, std::memory_order_relaxed);
+    event.name.store(name, std::memory_order_relaxed);
+    event.arg_name.store(arg_name, std::memory_order_relaxed);
+    event.arg.store(arg, std::memory_order_relaxed);
+    buffer->head.store(head + 1, std::memory_order_release);
+}
+
+int64_t TraceRecorder::WriteChromeTrace(const std::string& path) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    const std::string& out_path = path.empty() ? path_ : path;
+    if (out_path.empty())
+        return -1;
+
+    FILE* file = std::fopen(out_path.c_str(), "w");
+    if (!file) {
+        std::cerr << "Failed to open trace file " << out_path << std::endl;
+        return -1;
+    }
+
+    int64_t written = 0;
+    const char* separator = "\n";
+    std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (const auto& buffer : buffers_) {
+        std::string name = buffer->name.empty() ? "thread " + std::to_string(buffer->tid) : buffer->name;
+        std::fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     separator, buffer->tid, JsonEscape(name.c_str()).c_str());
+        separator = ",\n";
+
+        // the writer may still be running; anything at or before
+        // end - capacity may have been overwritten while copying
+        struct Copy {
+            uint64_t index;
+            int64_t ts_ns, dur_ns, arg;
+            const char* name;
+            const char* arg_name;
+        };
+        std::vector<Copy> copies;
+        uint64_t end = buffer->head.load(std::memory_order_acquire);
+        for (uint64_t i = end > buffer->capacity ? end - buffer->capacity : 0; i < end; ++i) {
+            const Event& event = buffer->events[i % buffer->capacity];
+            copies.push_back({i, event.ts_ns.load(std::memory_order_relaxed), event.dur_ns.load(std::memory_order_relaxed),
+                              event.arg.load(std::memory_order_relaxed), event.name.load(std::memory_order_relaxed),
+                              event.arg_name.load(std::memory_order_relaxed)});
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint64_t after = buffer->head.load(std::memory_order_relaxed);
+        uint64_t first_valid = after >= buffer->capacity ? after - buffer->capacity + 1 : 0;
+
+        for (const Copy& event : copies) {
+            if (event.index < first_valid || !event.name)
+                continue;
+            double ts_us = (event.ts_ns - start_ns_) / 1000.0;
+            std::fprintf(file, "%s{\"name\":\"%s\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", separator, JsonEscape(event.name).c_str(),
+                         buffer->tid, ts_us);
+            if (event.dur_ns >= 0) {
+                std::fprintf(file, ",\"ph\":\"X\",\"dur\":%.3f", event.dur_ns / 1000.0);
+            } else {
+                std::fprintf(file, ",\"ph\":\"i\",\"s\":\"t\"");
+            }
+            if (event.arg_name) {
+                std::fprintf(file, ",\"args\":{\"%s\":%lld}", JsonEscape(event.arg_name).c_str(), static_cast<long long>(event.arg));
+            }
+            std::fprintf(file, "}");
+            ++written;
+        }
+    }
+    std::fprintf(file, "\n]}\n");
+    std::fclose(file);
+
+    std::cout << "Wrote " << written << " trace events to " << out_path << std::endl;
+    return written;
+}
+
+} // namespace vr
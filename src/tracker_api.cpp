@@ -1,8 +1,78 @@
 #include "tracker_api.h"
 #include "tracker_device_driver.h"
+#include <cstring>
+#include <thread>
 
 namespace vr {
 
+namespace {
+
+const char* const kTrackerRoleNames[kNumTrackerRoles] = {
+    "Waist",
+    "LeftFoot",
+    "RightFoot",
+    "LeftKnee",
+    "RightKnee",
+    "LeftElbow",
+    "RightElbow",
+    "Chest"
+};
+
+// slot set owner while it is being released
+constexpr uint32_t kReleasingSession = 0xFFFFFFFF;
+
+// snapshot retries before settling for a mixed read
+constexpr int kSnapshotAttempts = 4;
+
+// a role counts as streamed by its sender for this long after its last pose
+constexpr int64_t kRoleHoldNs = 500000000;
+
+JointPose ToJointPose(const DriverPose_t& pose) {
+    JointPose joint;
+    joint.position = {static_cast<float>(pose.vecPosition[0]), static_cast<float>(pose.vecPosition[1]),
+                      static_cast<float>(pose.vecPosition[2])};
+    joint.rotation = pose.qRotation;
+    return joint;
+}
+
+JointPose ToJointPose(const DevicePose& pose) {
+    return {pose.position, pose.rotation};
+}
+
+} // namespace
+
+const char* GetTrackerRoleName(TrackerRole role) {
+    return role < TrackerRole::Count ? kTrackerRoleNames[static_cast<size_t>(role)] : "";
+}
+
+bool FindTrackerRole(const char* serial, TrackerRole& role) {
+    for (size_t i = 0; i < kNumTrackerRoles; ++i) {
+        if (strncmp(serial, kTrackerRoleNames[i], 16) == 0) {
+            role = static_cast<TrackerRole>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t SerialKeyHash::operator()(const SerialKey& key) const {
+    // fnv-1a
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : key.bytes) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return static_cast<size_t>(hash);
+}
+
+bool MakeSerialKey(const char* serial, SerialKey& key) {
+    size_t length = strnlen(serial, sizeof(key.bytes) + 1);
+    if (length > sizeof(key.bytes))
+        return false;
+    memset(key.bytes, 0, sizeof(key.bytes));
+    memcpy(key.bytes, serial, length);
+    return true;
+}
+
 TrackerAPI& TrackerAPI::GetInstance() {
     static TrackerAPI instance;
     return instance;
@@ -11,11 +81,33 @@ TrackerAPI& TrackerAPI::GetInstance() {
 void TrackerAPI::RegisterTracker(const std::string& serial_number, std::shared_ptr<TrackerDeviceDriver> tracker) {
     std::lock_guard<std::mutex> lock(trackers_mutex_);
     trackers_[serial_number] = tracker;
+    SerialKey key;
+    if (MakeSerialKey(serial_number.c_str(), key)) {
+        tracker_keys_[key] = tracker;
+    }
+    generation_.fetch_add(1, std::memory_order_release);
 }
 
 void TrackerAPI::UnregisterTracker(const std::string& serial_number) {
     std::lock_guard<std::mutex> lock(trackers_mutex_);
     trackers_.erase(serial_number);
+    SerialKey key;
+    if (MakeSerialKey(serial_number.c_str(), key)) {
+        tracker_keys_.erase(key);
+    }
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<TrackerDeviceDriver> TrackerAPI::FindTracker(const std::string& serial_number) {
+    std::lock_guard<std::mutex> lock(trackers_mutex_);
+    auto it = trackers_.find(serial_number);
+    return it != trackers_.end() ? it->second : nullptr;
+}
+
+std::shared_ptr<TrackerDeviceDriver> TrackerAPI::FindTracker(const SerialKey& serial) {
+    std::lock_guard<std::mutex> lock(trackers_mutex_);
+    auto it = tracker_keys_.find(serial);
+    return it != tracker_keys_.end() ? it->second : nullptr;
 }
 
 bool TrackerAPI::UpdateTrackerPose(const std::string& serial_number, 
@@ -30,34 +122,227 @@ bool TrackerAPI::UpdateTrackerPose(const std::string& serial_number,
     return false;
 }
 
-DevicePose TrackerAPI::GetHMDPose() const {
-    std::lock_guard<std::mutex> lock(device_poses_mutex_);
-    return hmd_pose_;
+bool TrackerAPI::UpdateTrackerStatus(const std::string& serial_number,
+                                   float battery,
+                                   bool charging,
+                                   bool connected) {
+    std::lock_guard<std::mutex> lock(trackers_mutex_);
+    auto it = trackers_.find(serial_number);
+    if (it != trackers_.end()) {
+        it->second->UpdateStatus(battery, charging, connected);
+        return true;
+    }
+    return false;
 }
 
-DevicePose TrackerAPI::GetControllerPose(bool is_left) const {
-    std::lock_guard<std::mutex> lock(device_poses_mutex_);
-    return is_left ? left_controller_pose_ : right_controller_pose_;
+void TrackerAPI::RegisterSlotSet(const std::array<std::shared_ptr<TrackerDeviceDriver>, kNumTrackerRoles>& trackers,
+                                 const BodyProportions& body) {
+    auto set = std::make_unique<TrackerSlotSet>();
+    set->trackers = trackers;
+    set->body = body;
+    for (auto& tracker : set->trackers) {
+        tracker->SetConnected(false);
+    }
+    slot_sets_.push_back(std::move(set));
 }
 
-void TrackerAPI::UpdateHMDPose(const HmdVector3_t& position, const HmdQuaternion_t& rotation) {
-    std::lock_guard<std::mutex> lock(device_poses_mutex_);
-    hmd_pose_.position = position;
-    hmd_pose_.rotation = rotation;
-    hmd_pose_.is_valid = true;
+void TrackerAPI::ClearSlotSets() {
+    slot_sets_.clear();
 }
 
-void TrackerAPI::UpdateControllerPose(bool is_left, const HmdVector3_t& position, const HmdQuaternion_t& rotation) {
-    std::lock_guard<std::mutex> lock(device_poses_mutex_);
-    if (is_left) {
-        left_controller_pose_.position = position;
-        left_controller_pose_.rotation = rotation;
-        left_controller_pose_.is_valid = true;
-    } else {
-        right_controller_pose_.position = position;
-        right_controller_pose_.rotation = rotation;
-        right_controller_pose_.is_valid = true;
+int TrackerAPI::AcquireSlotSet(uint32_t session_id, int64_t now_ns, int64_t timeout_ns) {
+    for (size_t i = 0; i < slot_sets_.size(); ++i) {
+        TrackerSlotSet& set = *slot_sets_[i];
+        uint32_t owner = set.owner.load(std::memory_order_acquire);
+        if (owner == kReleasingSession)
+            continue;
+        if (owner != 0 && now_ns - set.last_seen_ns.load(std::memory_order_relaxed) < timeout_ns)
+            continue;
+        if (!set.owner.compare_exchange_strong(owner, session_id))
+            continue;
+        set.last_seen_ns.store(now_ns, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(set.poses_mutex);
+            set.hmd_pose.is_valid = false;
+            set.left_controller_pose.is_valid = false;
+            set.right_controller_pose.is_valid = false;
+        }
+        for (auto& seen : set.role_seen_ns) {
+            seen.store(0, std::memory_order_relaxed);
+        }
+        set.publish_latency_ns.store(0, std::memory_order_relaxed);
+        for (auto& tracker : set.trackers) {
+            tracker->SetConnected(true);
+        }
+        return static_cast<int>(i);
     }
+    return -1;
+}
+
+bool TrackerAPI::TouchSlotSet(int set, uint32_t session_id, int64_t now_ns) {
+    TrackerSlotSet& slot_set = *slot_sets_[set];
+    if (slot_set.owner.load(std::memory_order_acquire) != session_id)
+        return false;
+    slot_set.last_seen_ns.store(now_ns, std::memory_order_relaxed);
+    return true;
+}
+
+void TrackerAPI::ReleaseSlotSet(int set, uint32_t session_id) {
+    TrackerSlotSet& slot_set = *slot_sets_[set];
+    // park the set so nobody acquires it while it is being disconnected
+    if (!slot_set.owner.compare_exchange_strong(session_id, kReleasingSession))
+        return;
+    for (auto& tracker : slot_set.trackers) {
+        tracker->SetConnected(false);
+    }
+    slot_set.owner.store(0, std::memory_order_release);
+}
+
+TrackerDeviceDriver* TrackerAPI::GetSlotTracker(int set, TrackerRole role) const {
+    return slot_sets_[set]->trackers[static_cast<size_t>(role)].get();
+}
+
+void TrackerAPI::BeginSlotSetWrite(int set) {
+    slot_sets_[set]->write_seq.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void TrackerAPI::EndSlotSetWrite(int set, int64_t received_ns, int64_t capture_ns) {
+    slot_sets_[set]->last_capture_ns.store(capture_ns, std::memory_order_relaxed);
+    slot_sets_[set]->last_write_ns.store(received_ns, std::memory_order_relaxed);
+    slot_sets_[set]->write_seq.fetch_add(1, std::memory_order_release);
+}
+
+void TrackerAPI::RecordPublish(int set, int64_t now_ns) {
+    TrackerSlotSet& slot_set = *slot_sets_[set];
+    int64_t written = slot_set.last_write_ns.load(std::memory_order_relaxed);
+    if (written == 0 || written == slot_set.last_published_write_ns)
+        return;
+    slot_set.last_published_write_ns = written;
+    int64_t captured = slot_set.last_capture_ns.load(std::memory_order_relaxed);
+
+    // moving average over ~8 samples
+    int64_t sample = now_ns - (captured != 0 ? captured : written);
+    int64_t average = slot_set.publish_latency_ns.load(std::memory_order_relaxed);
+    slot_set.publish_latency_ns.store(average == 0 ? sample : average + (sample - average) / 8, std::memory_order_relaxed);
+}
+
+int64_t TrackerAPI::GetPublishLatency(int set) const {
+    return slot_sets_[set]->publish_latency_ns.load(std::memory_order_relaxed);
+}
+
+void TrackerAPI::MarkRoleSeen(int set, TrackerRole role, int64_t now_ns) {
+    slot_sets_[set]->role_seen_ns[static_cast<size_t>(role)].store(now_ns, std::memory_order_relaxed);
+}
+
+void TrackerAPI::SolveDerivedTrackers(int set, int64_t now_ns, int64_t capture_ns) {
+    if (!derive_trackers_.load(std::memory_order_relaxed))
+        return;
+
+    TrackerSlotSet& slot_set = *slot_sets_[set];
+    auto streamed = [&](TrackerRole role) {
+        return now_ns - slot_set.role_seen_ns[static_cast<size_t>(role)].load(std::memory_order_relaxed) < kRoleHoldNs;
+    };
+    auto tracker_pose = [&](TrackerRole role) {
+        return ToJointPose(slot_set.trackers[static_cast<size_t>(role)]->GetPose());
+    };
+    auto update = [&](TrackerRole role, const JointPose& pose) {
+        slot_set.trackers[static_cast<size_t>(role)]->UpdatePose(pose.position, pose.rotation, capture_ns);
+    };
+
+    DevicePose head, left_hand, right_hand;
+    {
+        std::lock_guard<std::mutex> lock(slot_set.poses_mutex);
+        head = slot_set.hmd_pose;
+        left_hand = slot_set.left_controller_pose;
+        right_hand = slot_set.right_controller_pose;
+    }
+
+    // waist is the root of both chains
+    if (!streamed(TrackerRole::Waist))
+        return;
+    JointPose hip = tracker_pose(TrackerRole::Waist);
+
+    // chest before elbows, which hang off it
+    bool has_chest = streamed(TrackerRole::Chest);
+    JointPose chest{};
+    if (has_chest) {
+        chest = tracker_pose(TrackerRole::Chest);
+    } else if (head.is_valid) {
+        chest = SolveChest(slot_set.body, hip, ToJointPose(head));
+        update(TrackerRole::Chest, chest);
+        has_chest = true;
+    }
+
+    if (has_chest && left_hand.is_valid && !streamed(TrackerRole::LeftElbow)) {
+        update(TrackerRole::LeftElbow, SolveElbow(slot_set.body, chest, ToJointPose(left_hand), true));
+    }
+    if (has_chest && right_hand.is_valid && !streamed(TrackerRole::RightElbow)) {
+        update(TrackerRole::RightElbow, SolveElbow(slot_set.body, chest, ToJointPose(right_hand), false));
+    }
+
+    if (streamed(TrackerRole::LeftFoot) && !streamed(TrackerRole::LeftKnee)) {
+        update(TrackerRole::LeftKnee, SolveKnee(slot_set.body, hip, tracker_pose(TrackerRole::LeftFoot), true));
+    }
+    if (streamed(TrackerRole::RightFoot) && !streamed(TrackerRole::RightKnee)) {
+        update(TrackerRole::RightKnee, SolveKnee(slot_set.body, hip, tracker_pose(TrackerRole::RightFoot), false));
+    }
+}
+
+void TrackerAPI::SnapshotSlotSet(int set, std::array<DriverPose_t, kNumTrackerRoles>& poses) const {
+    const TrackerSlotSet& slot_set = *slot_sets_[set];
+    // each pose is read under its own lock, the sequence only keeps them
+    // from straddling two datagrams; give up after a few tries rather
+    // than stall the publisher behind a busy sender
+    for (int attempt = 0; attempt < kSnapshotAttempts; ++attempt) {
+        uint32_t before = slot_set.write_seq.load(std::memory_order_acquire);
+        if (before & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        for (size_t role = 0; role < kNumTrackerRoles; ++role) {
+            poses[role] = slot_set.trackers[role]->GetPose();
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot_set.write_seq.load(std::memory_order_relaxed) == before)
+            return;
+    }
+    for (size_t role = 0; role < kNumTrackerRoles; ++role) {
+        poses[role] = slot_set.trackers[role]->GetPose();
+    }
+}
+
+DevicePose TrackerAPI::GetHMDPose(int set) const {
+    if (set < 0 || set >= static_cast<int>(slot_sets_.size()))
+        return DevicePose{};
+    std::lock_guard<std::mutex> lock(slot_sets_[set]->poses_mutex);
+    return slot_sets_[set]->hmd_pose;
+}
+
+DevicePose TrackerAPI::GetControllerPose(bool is_left, int set) const {
+    if (set < 0 || set >= static_cast<int>(slot_sets_.size()))
+        return DevicePose{};
+    std::lock_guard<std::mutex> lock(slot_sets_[set]->poses_mutex);
+    return is_left ? slot_sets_[set]->left_controller_pose : slot_sets_[set]->right_controller_pose;
+}
+
+void TrackerAPI::UpdateHMDPose(const HmdVector3_t& position, const HmdQuaternion_t& rotation, int set) {
+    if (set < 0 || set >= static_cast<int>(slot_sets_.size()))
+        return;
+    std::lock_guard<std::mutex> lock(slot_sets_[set]->poses_mutex);
+    DevicePose& hmd_pose = slot_sets_[set]->hmd_pose;
+    hmd_pose.position = position;
+    hmd_pose.rotation = rotation;
+    hmd_pose.is_valid = true;
+}
+
+void TrackerAPI::UpdateControllerPose(bool is_left, const HmdVector3_t& position, const HmdQuaternion_t& rotation, int set) {
+    if (set < 0 || set >= static_cast<int>(slot_sets_.size()))
+        return;
+    std::lock_guard<std::mutex> lock(slot_sets_[set]->poses_mutex);
+    DevicePose& controller_pose = is_left ? slot_sets_[set]->left_controller_pose : slot_sets_[set]->right_controller_pose;
+    controller_pose.position = position;
+    controller_pose.rotation = rotation;
+    controller_pose.is_valid = true;
 }
 
-} // namespace vr 
\ No newline at end of file
+} // namespace vr
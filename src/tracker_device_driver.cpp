@@ -1,6 +1,12 @@
 #include "tracker_device_driver.h"
+#include "trace_recorder.h"
+#include "tracker_pose_publisher.h"
+#include <chrono>
 #include <cstring>
 
+// quiet time before another ingest worker may take over a slot
+static constexpr int64_t kIngestHandoverNs = 100000000;
+
 TrackerDeviceDriver::TrackerDeviceDriver(const std::string& serial_number, const std::string& model_number, vr::ETrackedDeviceClass device_class)
     : serial_number_(serial_number)
     , model_number_(model_number)
@@ -8,7 +14,13 @@ TrackerDeviceDriver::TrackerDeviceDriver(const std::string& serial_number, const
     , device_index_(vr::k_unTrackedDeviceIndexInvalid)
     , is_active_(false)
     , is_connected_(true)
+    , is_standby_(false)
+    , ingest_owner_(-1)
+    , ingest_last_update_(0)
+    , property_container_(vr::k_ulInvalidPropertyContainer)
 {
+    current_pose_ = {};
+    current_pose_.qRotation = {1, 0, 0, 0};
     current_pose_.poseIsValid = true;
     current_pose_.result = vr::TrackingResult_Running_OK;
     current_pose_.deviceIsConnected = true;
@@ -20,35 +32,51 @@ TrackerDeviceDriver::TrackerDeviceDriver(const std::string& serial_number, const
     current_pose_.vecDriverFromHeadTranslation[0] = 0.0;
     current_pose_.vecDriverFromHeadTranslation[1] = 0.0;
     current_pose_.vecDriverFromHeadTranslation[2] = 0.0;
+
+    // initial properties, written on activate
+    property_cache_.SetString(vr::Prop_ModelNumber_String, model_number_);
+    property_cache_.SetString(vr::Prop_SerialNumber_String, serial_number_);
+    property_cache_.SetInt32(vr::Prop_DeviceClass_Int32, device_class_);
+    property_cache_.SetBool(vr::Prop_WillDriftInYaw_Bool, false);
+    property_cache_.SetBool(vr::Prop_DeviceIsWireless_Bool, true);
+    property_cache_.SetBool(vr::Prop_DeviceProvidesBatteryStatus_Bool, true);
+    property_cache_.SetBool(vr::Prop_DeviceIsCharging_Bool, false);
+    property_cache_.SetFloat(vr::Prop_DeviceBatteryPercentage_Float, 1.0f);
 }
 
 vr::EVRInitError TrackerDeviceDriver::Activate(uint32_t unObjectId) {
     device_index_ = unObjectId;
+    property_container_ = vr::VRProperties()->TrackedDeviceToPropertyContainer(device_index_);
     is_active_ = true;
 
     // register inputs
-    vr::VRDriverInput()->CreateBooleanComponent(device_index_, "/input/trigger/click", &input_handles_[TrackerComponent_trigger_click]);
-    vr::VRDriverInput()->CreateScalarComponent(device_index_, "/input/trigger/value", &input_handles_[TrackerComponent_trigger_value], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedOneSided);
-
-    // set properties
-    vr::VRProperties()->SetStringProperty(device_index_, vr::Prop_ModelNumber_String, model_number_.c_str());
-    vr::VRProperties()->SetStringProperty(device_index_, vr::Prop_SerialNumber_String, serial_number_.c_str());
-    vr::VRProperties()->SetInt32Property(device_index_, vr::Prop_DeviceClass_Int32, device_class_);
-    vr::VRProperties()->SetBoolProperty(device_index_, vr::Prop_WillDriftInYaw_Bool, false);
-    vr::VRProperties()->SetBoolProperty(device_index_, vr::Prop_DeviceIsWireless_Bool, true);
-    vr::VRProperties()->SetBoolProperty(device_index_, vr::Prop_DeviceIsCharging_Bool, false);
-    vr::VRProperties()->SetFloatProperty(device_index_, vr::Prop_DeviceBatteryPercentage_Float, 1.0f);
+    vr::VRDriverInput()->CreateBooleanComponent(property_container_, "/input/trigger/click", &input_handles_[TrackerComponent_trigger_click]);
+    vr::VRDriverInput()->CreateScalarComponent(property_container_, "/input/trigger/value", &input_handles_[TrackerComponent_trigger_value], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedOneSided);
+
+    // write all cached properties
+    property_cache_.Invalidate();
+    property_cache_.Flush(property_container_);
 
     return vr::VRInitError_None;
 }
 
 void TrackerDeviceDriver::Deactivate() {
     device_index_ = vr::k_unTrackedDeviceIndexInvalid;
+    property_container_ = vr::k_ulInvalidPropertyContainer;
     is_active_ = false;
 }
 
 void TrackerDeviceDriver::EnterStandby() {
-    // standby mode
+    // never left by vrserver, standby is driven by the provider
+}
+
+void TrackerDeviceDriver::Suspend() {
+    // ingest keeps the newest pose of each burst, so the first one after wake is current
+    is_standby_ = true;
+}
+
+void TrackerDeviceDriver::Resume() {
+    is_standby_ = false;
 }
 
 void* TrackerDeviceDriver::GetComponent(const char* pchComponentNameAndVersion) {
@@ -58,28 +86,97 @@ void* TrackerDeviceDriver::GetComponent(const char* pchComponentNameAndVersion)
 void TrackerDeviceDriver::DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) {
     if (unResponseBufferSize >= 1)
         pchResponseBuffer[0] = 0;
+
+    // "trace_dump [path]" writes the trace rings, default path from settings
+    if (strncmp(pchRequest, "trace_dump", 10) == 0 && (pchRequest[10] == '\0' || pchRequest[10] == ' ')) {
+        std::string path = pchRequest[10] == ' ' ? std::string(pchRequest + 11) : std::string();
+        int64_t written = vr::TraceRecorder::IsEnabled() ? vr::TraceRecorder::GetInstance().WriteChromeTrace(path) : -1;
+        if (unResponseBufferSize >= 1)
+            snprintf(pchResponseBuffer, unResponseBufferSize, written < 0 ? "trace not written" : "wrote %lld trace events",
+                     static_cast<long long>(written));
+    }
+
+    // "publisher_stats" reports the publisher thread's tick timing so far
+    if (strcmp(pchRequest, "publisher_stats") == 0 && unResponseBufferSize >= 1) {
+        vr::PublisherStats stats;
+        if (vr::TrackerPosePublisher::GetRunningStats(stats)) {
+            snprintf(pchResponseBuffer, unResponseBufferSize, "%llu ticks at %.1f Hz, jitter mean %.1f us, max %.1f us, %llu late",
+                     static_cast<unsigned long long>(stats.ticks), stats.rate_hz, stats.mean_jitter_us, stats.max_jitter_us,
+                     static_cast<unsigned long long>(stats.late_ticks));
+        } else {
+            snprintf(pchResponseBuffer, unResponseBufferSize, "publisher not running");
+        }
+    }
 }
 
 vr::DriverPose_t TrackerDeviceDriver::GetPose() {
     std::lock_guard<std::mutex> lock(pose_mutex_);
-    return current_pose_;
+    vr::DriverPose_t pose = current_pose_;
+    // age of the sample, vrserver predicts forward from it
+    if (capture_ns_ != 0) {
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        pose.poseTimeOffset = static_cast<double>(capture_ns_ - now) / 1e9;
+    }
+    return pose;
 }
 
-void TrackerDeviceDriver::UpdatePose(const vr::HmdVector3_t& position, const vr::HmdQuaternion_t& rotation) {
+void TrackerDeviceDriver::UpdatePose(const vr::HmdVector3_t& position, const vr::HmdQuaternion_t& rotation, int64_t capture_ns) {
+    vr::TraceInstant("apply", "device", device_index_);
     std::lock_guard<std::mutex> lock(pose_mutex_);
+    capture_ns_ = capture_ns;
     current_pose_.vecPosition[0] = position.v[0];
     current_pose_.vecPosition[1] = position.v[1];
     current_pose_.vecPosition[2] = position.v[2];
     current_pose_.qRotation = rotation;
 }
 
+void TrackerDeviceDriver::UpdateStatus(float battery, bool charging, bool connected) {
+    property_cache_.SetFloat(vr::Prop_DeviceBatteryPercentage_Float, battery);
+    property_cache_.SetBool(vr::Prop_DeviceIsCharging_Bool, charging);
+    SetConnected(connected);
+}
+
+void TrackerDeviceDriver::SetConnected(bool connected) {
+    std::lock_guard<std::mutex> lock(pose_mutex_);
+    is_connected_ = connected;
+    current_pose_.deviceIsConnected = connected;
+}
+
+bool TrackerDeviceDriver::ClaimIngest(int worker_id, int64_t now_ns) {
+    int owner = ingest_owner_.load(std::memory_order_acquire);
+    if (owner != worker_id) {
+        if (owner != -1 && now_ns - ingest_last_update_.load(std::memory_order_relaxed) < kIngestHandoverNs)
+            return false;
+        if (!ingest_owner_.compare_exchange_strong(owner, worker_id))
+            return false;
+    }
+    ingest_last_update_.store(now_ns, std::memory_order_relaxed);
+    return true;
+}
+
+void TrackerDeviceDriver::ReleaseIngest(int worker_id) {
+    int expected = worker_id;
+    ingest_owner_.compare_exchange_strong(expected, -1);
+}
+
+void TrackerDeviceDriver::PublishPose(const vr::DriverPose_t& pose) {
+    if (!is_active_ || is_standby_)
+        return;
+    vr::TraceInstant("publish", "device", device_index_);
+    vr::VRServerDriverHost()->TrackedDevicePoseUpdated(device_index_, pose, sizeof(vr::DriverPose_t));
+}
+
 void TrackerDeviceDriver::RunFrame() {
-    if (!is_active_ || !is_connected_)
+    if (!is_active_ || is_standby_)
+        return;
+
+    // write changed properties, held back in standby
+    property_cache_.Flush(property_container_);
+
+    if (!is_connected_)
         return;
 
-    // update properties
-    vr::VRProperties()->SetBoolProperty(device_index_, vr::Prop_DeviceIsWireless_Bool, is_connected_);
-    
     // update inputs
     // vr::VRDriverInput()->UpdateBooleanComponent(input_handles_[TrackerComponent_trigger_click], false, 0.0);
     // vr::VRDriverInput()->UpdateScalarComponent(input_handles_[TrackerComponent_trigger_value], 0.0f, 0.0);
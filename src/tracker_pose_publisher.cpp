@@ -0,0 +1,165 @@
+#include "tracker_pose_publisher.h"
+#include "tracker_api.h"
+#include "tracker_device_driver.h"
+#include "trace_recorder.h"
+#include <array>
+#include <chrono>
+#include <iostream>
+#include <openvr_driver.h>
+
+namespace vr {
+
+namespace {
+
+// sleep until this close to the deadline, then yield-spin
+constexpr auto kSpinMargin = std::chrono::microseconds(200);
+
+// how often the display rate is re-read
+constexpr auto kDisplayPollInterval = std::chrono::seconds(1);
+
+constexpr double kDefaultRateHz = 90.0;
+
+} // namespace
+
+std::atomic<TrackerPosePublisher*> TrackerPosePublisher::running_publisher_{nullptr};
+
+TrackerPosePublisher::~TrackerPosePublisher() {
+    Stop();
+}
+
+bool TrackerPosePublisher::Start(double rate_hz, bool follow_display) {
+    if (running_) return false;
+    rate_hz_ = rate_hz > 0.0 ? rate_hz : kDefaultRateHz;
+    follow_display_ = follow_display;
+    ticks_ = 0;
+    late_ticks_ = 0;
+    jitter_sum_ns_ = 0;
+    jitter_max_ns_ = 0;
+    running_ = true;
+    thread_ = std::make_unique<std::thread>(&TrackerPosePublisher::Run, this);
+    running_publisher_ = this;
+    return true;
+}
+
+void TrackerPosePublisher::Stop() {
+    if (!running_) return;
+    TrackerPosePublisher* self = this;
+    running_publisher_.compare_exchange_strong(self, nullptr);
+    {
+        std::lock_guard<std::mutex> lock(standby_mutex_);
+        running_ = false;
+    }
+    standby_cv_.notify_all();
+    if (thread_ && thread_->joinable()) {
+        thread_->join();
+    }
+    thread_.reset();
+
+    PublisherStats stats = GetStats();
+    std::cout << "Pose publisher stopped after " << stats.ticks << " ticks at " << stats.rate_hz
+              << " Hz, jitter mean " << stats.mean_jitter_us << " us, max " << stats.max_jitter_us
+              << " us, " << stats.late_ticks << " late" << std::endl;
+}
+
+void TrackerPosePublisher::SetStandby(bool standby) {
+    {
+        std::lock_guard<std::mutex> lock(standby_mutex_);
+        standby_ = standby;
+    }
+    standby_cv_.notify_all();
+}
+
+void TrackerPosePublisher::PublishAll() {
+    TrackerAPI& api = TrackerAPI::GetInstance();
+    TraceScope trace("publish pass", "sets", static_cast<int64_t>(api.GetSlotSetCount()));
+    std::array<DriverPose_t, kNumTrackerRoles> poses;
+    int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    for (size_t set = 0; set < api.GetSlotSetCount(); ++set) {
+        api.SnapshotSlotSet(static_cast<int>(set), poses);
+        for (size_t role = 0; role < kNumTrackerRoles; ++role) {
+            api.GetSlotTracker(static_cast<int>(set), static_cast<TrackerRole>(role))->PublishPose(poses[role]);
+        }
+        api.RecordPublish(static_cast<int>(set), now);
+    }
+}
+
+PublisherStats TrackerPosePublisher::GetStats() const {
+    PublisherStats stats;
+    stats.ticks = ticks_.load(std::memory_order_relaxed);
+    stats.late_ticks = late_ticks_.load(std::memory_order_relaxed);
+    stats.rate_hz = rate_hz_.load(std::memory_order_relaxed);
+    if (stats.ticks > 0) {
+        stats.mean_jitter_us = jitter_sum_ns_.load(std::memory_order_relaxed) / 1000.0 / stats.ticks;
+    }
+    stats.max_jitter_us = jitter_max_ns_.load(std::memory_order_relaxed) / 1000.0;
+    return stats;
+}
+
+bool TrackerPosePublisher::GetRunningStats(PublisherStats& stats) {
+    TrackerPosePublisher* publisher = running_publisher_.load();
+    if (!publisher)
+        return false;
+    stats = publisher->GetStats();
+    return true;
+}
+
+double TrackerPosePublisher::ReadDisplayFrequency() const {
+    CVRPropertyHelpers* properties = VRProperties();
+    if (!properties)
+        return 0.0;
+    PropertyContainerHandle_t container = properties->TrackedDeviceToPropertyContainer(k_unTrackedDeviceIndex_Hmd);
+    return properties->GetFloatProperty(container, Prop_DisplayFrequency_Float);
+}
+
+void TrackerPosePublisher::Run() {
+    using clock = std::chrono::steady_clock;
+    TraceRecorder::GetInstance().SetThreadName("pose publisher");
+
+    auto next = clock::now();
+    auto next_display_poll = next;
+    while (running_) {
+        if (standby_) {
+            std::unique_lock<std::mutex> lock(standby_mutex_);
+            standby_cv_.wait(lock, [this] { return !standby_ || !running_; });
+            // no catching up on the ticks missed while parked
+            next = clock::now();
+            continue;
+        }
+
+        if (follow_display_ && clock::now() >= next_display_poll) {
+            double display_hz = ReadDisplayFrequency();
+            if (display_hz > 0.0 && display_hz != rate_hz_) {
+                rate_hz_ = display_hz;
+                std::cout << "Pose publisher following display at " << display_hz << " Hz" << std::endl;
+            }
+            next_display_poll = clock::now() + kDisplayPollInterval;
+        }
+        auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / rate_hz_));
+
+        // absolute deadlines, so the rate doesn't drift with publish cost
+        next += period;
+        std::this_thread::sleep_until(next - kSpinMargin);
+        while (clock::now() < next) {
+            std::this_thread::yield();
+        }
+
+        auto woke = clock::now();
+        int64_t jitter = std::chrono::duration_cast<std::chrono::nanoseconds>(woke - next).count();
+        jitter_sum_ns_.fetch_add(jitter, std::memory_order_relaxed);
+        if (jitter > jitter_max_ns_.load(std::memory_order_relaxed)) {
+            jitter_max_ns_.store(jitter, std::memory_order_relaxed);
+        }
+        ticks_.fetch_add(1, std::memory_order_relaxed);
+
+        // missed a whole period, skip ahead instead of bursting
+        if (woke - next > period) {
+            late_ticks_.fetch_add(1, std::memory_order_relaxed);
+            next = woke;
+        }
+
+        PublishAll();
+    }
+}
+
+} // namespace vr
@@ -0,0 +1,122 @@
+#include "tracker_property_cache.h"
+#include <iostream>
+
+TrackerPropertyCache::Entry* TrackerPropertyCache::FindOrAdd(vr::ETrackedDeviceProperty prop, vr::PropertyTypeTag_t tag) {
+    for (size_t i = 0; i < count_; ++i) {
+        if (entries_[i].prop == prop) {
+            return entries_[i].tag == tag ? &entries_[i] : nullptr;
+        }
+    }
+    if (count_ >= kMaxProperties) {
+        std::cerr << "Property cache full, dropping property " << prop << std::endl;
+        return nullptr;
+    }
+    Entry& entry = entries_[count_++];
+    entry.prop = prop;
+    entry.tag = tag;
+    entry.dirty = true;
+    return &entry;
+}
+
+void TrackerPropertyCache::SetBool(vr::ETrackedDeviceProperty prop, bool value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(prop, vr::k_unBoolPropertyTag);
+    if (!entry || (!entry->dirty && entry->value.b == value))
+        return;
+    entry->value.b = value;
+    entry->dirty = true;
+    dirty_ = true;
+}
+
+void TrackerPropertyCache::SetFloat(vr::ETrackedDeviceProperty prop, float value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(prop, vr::k_unFloatPropertyTag);
+    if (!entry || (!entry->dirty && entry->value.f == value))
+        return;
+    entry->value.f = value;
+    entry->dirty = true;
+    dirty_ = true;
+}
+
+void TrackerPropertyCache::SetInt32(vr::ETrackedDeviceProperty prop, int32_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(prop, vr::k_unInt32PropertyTag);
+    if (!entry || (!entry->dirty && entry->value.i == value))
+        return;
+    entry->value.i = value;
+    entry->dirty = true;
+    dirty_ = true;
+}
+
+void TrackerPropertyCache::SetString(vr::ETrackedDeviceProperty prop, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry* entry = FindOrAdd(prop, vr::k_unStringPropertyTag);
+    if (!entry || (!entry->dirty && entry->str == value))
+        return;
+    entry->str = value;
+    entry->dirty = true;
+    dirty_ = true;
+}
+
+void TrackerPropertyCache::Invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < count_; ++i) {
+        entries_[i].dirty = true;
+    }
+    dirty_ = count_ > 0;
+}
+
+uint32_t TrackerPropertyCache::Flush(vr::PropertyContainerHandle_t container) {
+    // steady state: nothing changed
+    if (!dirty_.load(std::memory_order_acquire))
+        return 0;
+    if (container == vr::k_ulInvalidPropertyContainer)
+        return 0;
+
+    // copy out so the write happens without holding the lock
+    std::array<Entry, kMaxProperties> staged;
+    uint32_t num_staged = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (size_t i = 0; i < count_; ++i) {
+            if (entries_[i].dirty) {
+                staged[num_staged++] = entries_[i];
+                entries_[i].dirty = false;
+            }
+        }
+        dirty_ = false;
+    }
+    if (num_staged == 0)
+        return 0;
+
+    std::array<vr::PropertyWrite_t, kMaxProperties> batch{};
+    for (uint32_t i = 0; i < num_staged; ++i) {
+        Entry& entry = staged[i];
+        vr::PropertyWrite_t& write = batch[i];
+        write.prop = entry.prop;
+        write.writeType = vr::PropertyWrite_Set;
+        write.unTag = entry.tag;
+        switch (entry.tag) {
+            case vr::k_unBoolPropertyTag:
+                write.pvBuffer = &entry.value.b;
+                write.unBufferSize = sizeof(entry.value.b);
+                break;
+            case vr::k_unFloatPropertyTag:
+                write.pvBuffer = &entry.value.f;
+                write.unBufferSize = sizeof(entry.value.f);
+                break;
+            case vr::k_unInt32PropertyTag:
+                write.pvBuffer = &entry.value.i;
+                write.unBufferSize = sizeof(entry.value.i);
+                break;
+            default:
+                write.pvBuffer = const_cast<char*>(entry.str.c_str());
+                write.unBufferSize = static_cast<uint32_t>(entry.str.size() + 1);
+                break;
+        }
+    }
+
+    // single cross-process call
+    vr::VRPropertiesRaw()->WritePropertyBatch(container, batch.data(), num_staged);
+    return num_staged;
+}
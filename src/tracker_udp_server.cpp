@@ -1,18 +1,303 @@
 #include "tracker_udp_server.h"
 #include "tracker_api.h"
+#include "tracker_device_driver.h"
+#include "trace_recorder.h"
+#include <algorithm>
 #include <cstring>
 #include <iostream>
+#include <chrono>
 #ifdef _WIN32
 #include <winsock2.h>
+#include <ws2tcpip.h>
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <sys/socket.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
 #include <unistd.h>
 #endif
 
 namespace vr {
 
+namespace {
+
+#ifdef SO_REUSEPORT
+constexpr bool kHasReusePort = true;
+#else
+constexpr bool kHasReusePort = false;
+#endif
+
+// recv timeout so workers notice Stop()
+constexpr int kRecvTimeoutMs = 100;
+
+// standby: longer recv timeout, datagrams queue up between bursts
+constexpr int kStandbyRecvTimeoutMs = 500;
+constexpr auto kStandbyPollInterval = std::chrono::milliseconds(100);
+
+// rate senders are asked for in standby, one burst per datagram
+constexpr float kStandbyRateHz = 10.0f;
+
+// longest SetStandby(false) waits for parked workers
+constexpr auto kWakeTimeout = std::chrono::milliseconds(20);
+
+// how often sessions are checked for timeout
+constexpr int64_t kSessionSweepNs = 250000000;
+
+// retry interval for sessions without a slot set
+constexpr int64_t kAcquireRetryNs = 100000000;
+
+// feedback per sender, and how often workers check the back channel
+constexpr int64_t kFeedbackIntervalNs = 500000000;
+constexpr int64_t kBackChannelCheckNs = 100000000;
+
+// clock pings per sender, faster until the first estimate
+constexpr int64_t kClockPingIntervalNs = 1000000000;
+constexpr int64_t kClockPingFastNs = 100000000;
+
+// optional batch trailer, sequence then capture time
+constexpr size_t kSequenceSize = sizeof(uint32_t);
+constexpr size_t kCaptureTimeSize = sizeof(int64_t);
+
+static_assert(sizeof(SenderSession::standby_datagram) >= sizeof(UdpBatchPacket) + kSequenceSize + kCaptureTimeSize,
+              "standby datagram can't hold a full batch");
+
+// pose bytes of a batch, 0 for a single packet or a malformed batch
+size_t BatchSize(const char* buffer, size_t size) {
+    if (size == sizeof(UdpPosePacket))
+        return 0;
+    const UdpBatchPacket* batch = reinterpret_cast<const UdpBatchPacket*>(buffer);
+    if (batch->num_devices == 0 || batch->num_devices > 8)
+        return 0;
+    size_t batch_size = 1 + batch->num_devices * sizeof(UdpPosePacket);
+    return size >= batch_size ? batch_size : 0;
+}
+
+std::atomic<uint32_t> next_session_id{1};
+
+uint32_t NextSessionId() {
+    uint32_t id;
+    do {
+        id = next_session_id.fetch_add(1, std::memory_order_relaxed);
+    } while (id == 0 || id == 0xFFFFFFFF);
+    return id;
+}
+
+int64_t NowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void CloseSocket(int sockfd) {
+#ifdef _WIN32
+    closesocket(sockfd);
+#else
+    close(sockfd);
+#endif
+}
+
+void SetRecvTimeout(int sockfd, int timeout_ms) {
+#ifdef _WIN32
+    DWORD timeout = timeout_ms;
+#else
+    timeval timeout{};
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_usec = (timeout_ms % 1000) * 1000;
+#endif
+    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+}
+
+// a datagram is waiting, without blocking. poll rather than select,
+// inside vrserver the fd can be past FD_SETSIZE
+bool HasPendingDatagram(int sockfd) {
+#ifdef _WIN32
+    WSAPOLLFD entry{};
+    entry.fd = sockfd;
+    entry.events = POLLRDNORM;
+    return WSAPoll(&entry, 1, 0) > 0 && (entry.revents & POLLRDNORM) != 0;
+#else
+    pollfd entry{};
+    entry.fd = sockfd;
+    entry.events = POLLIN;
+    return poll(&entry, 1, 0) > 0 && (entry.revents & POLLIN) != 0;
+#endif
+}
+
+#if defined(__linux__)
+// leaving SCHED_IDLE needs CAP_SYS_NICE or a RLIMIT_NICE that covers the
+// current nice value, otherwise the thread would stay idle after wake
+bool CanLeaveIdlePriority() {
+    if (geteuid() == 0)
+        return true;
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NICE, &limit) != 0)
+        return false;
+    int nice = getpriority(PRIO_PROCESS, 0);
+    return limit.rlim_cur == RLIM_INFINITY || static_cast<rlim_t>(20 - nice) <= limit.rlim_cur;
+}
+#endif
+
+// lowest priority for the calling thread in standby, false if unchanged
+bool SetIdlePriority(bool idle) {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), idle ? THREAD_PRIORITY_LOWEST : THREAD_PRIORITY_NORMAL) != 0;
+#elif defined(__linux__)
+    if (idle && !CanLeaveIdlePriority())
+        return false;
+    sched_param param{};
+    return pthread_setschedparam(pthread_self(), idle ? SCHED_IDLE : SCHED_OTHER, &param) == 0;
+#else
+    return false;
+#endif
+}
+
+// one socket of the given family bound to port, joined to the group if
+// any. an ipv4 group is joined on a dual-stack socket too
+int OpenSocketFamily(int family, int port, bool reuse_port, const in_addr* group4, const in6_addr* group6) {
+    int sockfd = socket(family, SOCK_DGRAM, 0);
+    if (sockfd < 0)
+        return -1;
+    if (family == AF_INET6) {
+        int v6only = 0;
+        setsockopt(sockfd, IPPROTO_IPV6, IPV6_V6ONLY, reinterpret_cast<const char*>(&v6only), sizeof(v6only));
+    }
+#ifdef _WIN32
+    // SO_REUSEADDR would let any process take the port over
+    int exclusive = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, reinterpret_cast<const char*>(&exclusive), sizeof(exclusive));
+#endif
+#ifdef SO_REUSEPORT
+    if (reuse_port) {
+        int enable = 1;
+        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &enable, sizeof(enable)) < 0) {
+            std::cerr << "UDP socket SO_REUSEPORT failed" << std::endl;
+            CloseSocket(sockfd);
+            return -1;
+        }
+    }
+#endif
+    SetRecvTimeout(sockfd, kRecvTimeoutMs);
+
+    sockaddr_storage servaddr{};
+    socklen_t servaddr_len;
+    if (family == AF_INET6) {
+        sockaddr_in6& addr = reinterpret_cast<sockaddr_in6&>(servaddr);
+        addr.sin6_family = AF_INET6;
+        addr.sin6_addr = in6addr_any;
+        addr.sin6_port = htons(port);
+        servaddr_len = sizeof(addr);
+    } else {
+        sockaddr_in& addr = reinterpret_cast<sockaddr_in&>(servaddr);
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = INADDR_ANY;
+        addr.sin_port = htons(port);
+        servaddr_len = sizeof(addr);
+    }
+    if (bind(sockfd, reinterpret_cast<sockaddr*>(&servaddr), servaddr_len) < 0) {
+        std::cerr << "UDP socket bind failed" << std::endl;
+        CloseSocket(sockfd);
+        return -1;
+    }
+
+    int joined = 0;
+    if (group4) {
+        ip_mreq request{};
+        request.imr_multiaddr = *group4;
+        request.imr_interface.s_addr = INADDR_ANY;
+        joined = setsockopt(sockfd, IPPROTO_IP, IP_ADD_MEMBERSHIP, reinterpret_cast<const char*>(&request), sizeof(request));
+    } else if (group6) {
+        ipv6_mreq request{};
+        request.ipv6mr_multiaddr = *group6;
+        request.ipv6mr_interface = 0;
+        joined = setsockopt(sockfd, IPPROTO_IPV6, IPV6_JOIN_GROUP, reinterpret_cast<const char*>(&request), sizeof(request));
+    }
+    if (joined < 0) {
+        CloseSocket(sockfd);
+        return -1;
+    }
+    return sockfd;
+}
+
+// dual-stack ipv6, falling back to ipv4 where ipv6 is unavailable or an
+// ipv4 group can't be joined on it. a group is joined on the default
+// interface. with a group the port is shared (SO_REUSEPORT, not on
+// windows) so several consumers on one host can listen to it
+int OpenSocket(int port, bool reuse_port, const std::string& group, int& family) {
+    in_addr group4{};
+    in6_addr group6{};
+    bool join4 = false;
+    bool join6 = false;
+    if (!group.empty()) {
+        join4 = inet_pton(AF_INET, group.c_str(), &group4) == 1;
+        join6 = !join4 && inet_pton(AF_INET6, group.c_str(), &group6) == 1;
+        if (!join4 && !join6) {
+            std::cerr << "UDP multicast group " << group << " is not an IP address" << std::endl;
+            return -1;
+        }
+    }
+    reuse_port = reuse_port || !group.empty();
+
+    family = AF_INET6;
+    int sockfd = OpenSocketFamily(family, port, reuse_port, join4 ? &group4 : nullptr, join6 ? &group6 : nullptr);
+    if (sockfd < 0 && !join6) {
+        family = AF_INET;
+        sockfd = OpenSocketFamily(family, port, reuse_port, join4 ? &group4 : nullptr, nullptr);
+        if (sockfd >= 0 && join4) {
+            std::cerr << "UDP multicast group " << group << " joined on ipv4 only, ipv6 senders can't reach this driver" << std::endl;
+        }
+    }
+    if (sockfd < 0) {
+        std::cerr << "UDP socket on port " << port << (group.empty() ? "" : " with multicast group " + group) << " failed" << std::endl;
+        return -1;
+    }
+    return sockfd;
+}
+
+SenderKey KeyFromSockaddr(const sockaddr_storage& addr, uint32_t& scope_id) {
+    if (addr.ss_family == AF_INET6) {
+        const sockaddr_in6& addr6 = reinterpret_cast<const sockaddr_in6&>(addr);
+        scope_id = addr6.sin6_scope_id;
+        return MakeSenderKey(addr6.sin6_addr.s6_addr, addr6.sin6_port);
+    }
+    const sockaddr_in& addr4 = reinterpret_cast<const sockaddr_in&>(addr);
+    scope_id = 0;
+    return MakeSenderKey(addr4.sin_addr.s_addr, addr4.sin_port);
+}
+
+// reply address for a socket of this family, ipv4 stays mapped on ipv6
+socklen_t ToSockaddr(const SenderSession& session, int family, sockaddr_storage& out) {
+    out = sockaddr_storage{};
+    if (family == AF_INET6) {
+        sockaddr_in6& addr = reinterpret_cast<sockaddr_in6&>(out);
+        addr.sin6_family = AF_INET6;
+        addr.sin6_port = session.key.port;
+        addr.sin6_scope_id = session.scope_id;
+        memcpy(&addr.sin6_addr, session.key.addr, sizeof(addr.sin6_addr));
+        return sizeof(addr);
+    }
+    sockaddr_in& addr = reinterpret_cast<sockaddr_in&>(out);
+    addr.sin_family = AF_INET;
+    addr.sin_port = session.key.port;
+    memcpy(&addr.sin_addr, &session.key.addr[12], sizeof(addr.sin_addr));
+    return sizeof(addr);
+}
+
+// devices a sender with a slot set should stream
+uint16_t NeededDevices() {
+    constexpr auto bit = [](TrackerRole role) { return static_cast<uint16_t>(1u << static_cast<unsigned>(role)); };
+    if (!TrackerAPI::GetInstance().GetDeriveTrackers())
+        return (1u << kNumTrackerRoles) - 1;
+    // the rest are derived from these, head and hands are only read by the solver
+    return FeedbackDevice_HMD | FeedbackDevice_LeftController | FeedbackDevice_RightController |
+           bit(TrackerRole::Waist) | bit(TrackerRole::LeftFoot) | bit(TrackerRole::RightFoot);
+}
+
+} // namespace
+
 TrackerUDPServer& TrackerUDPServer::GetInstance() {
     static TrackerUDPServer instance;
     return instance;
@@ -24,23 +309,290 @@ TrackerUDPServer::~TrackerUDPServer() {
     Stop();
 }
 
-bool TrackerUDPServer::Start(int port) {
+bool TrackerUDPServer::Start(int port, int num_workers, int session_timeout_ms) {
     if (running_) return false;
     port_ = port;
+    session_timeout_ns_ = static_cast<int64_t>(session_timeout_ms) * 1000000;
+    if (num_workers < 1) num_workers = 1;
+    // every socket on the port gets its own copy of a multicast datagram
+    if (!multicast_group_.empty() && num_workers > 1) {
+        std::cout << "UDP multicast uses a single ingest worker" << std::endl;
+        num_workers = 1;
+    }
     running_ = true;
-    server_thread_ = std::make_unique<std::thread>(&TrackerUDPServer::RunServer, this);
+    for (int i = 0; i < num_workers; ++i) {
+        auto worker = std::make_unique<IngestWorker>();
+        worker->id = i;
+        worker->port = kHasReusePort ? port : port + i;
+        workers_.push_back(std::move(worker));
+    }
+    for (auto& worker : workers_) {
+        worker->thread = std::make_unique<std::thread>(&TrackerUDPServer::RunServer, this, std::ref(*worker));
+    }
     return true;
 }
 
 void TrackerUDPServer::Stop() {
     if (!running_) return;
-    running_ = false;
-    if (server_thread_ && server_thread_->joinable()) {
-        server_thread_->join();
+    {
+        std::lock_guard<std::mutex> lock(standby_mutex_);
+        running_ = false;
     }
+    standby_cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread && worker->thread->joinable()) {
+            worker->thread->join();
+        }
+    }
+    workers_.clear();
+}
+
+void TrackerUDPServer::SetStandby(bool standby) {
+    std::unique_lock<std::mutex> lock(standby_mutex_);
+    standby_ = standby;
+    standby_cv_.notify_all();
+    if (standby)
+        return;
+
+    standby_cv_.wait_for(lock, kWakeTimeout, [this] {
+        for (const auto& worker : workers_) {
+            if (worker->waking) return false;
+        }
+        return true;
+    });
 }
 
-void TrackerUDPServer::HandlePosePacket(const UdpPosePacket& packet) {
+IngestStats TrackerUDPServer::GetStats() const {
+    IngestStats stats;
+    for (const auto& worker : workers_) {
+        stats.datagrams += worker->datagrams.load(std::memory_order_relaxed);
+        stats.updates += worker->updates.load(std::memory_order_relaxed);
+        stats.dropped += worker->dropped.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+SenderSession* TrackerUDPServer::UpdateSession(IngestWorker& worker, const SenderKey& key, int64_t now) {
+    SenderSession* session = worker.sessions.Find(key);
+    if (!session) {
+        session = worker.sessions.Insert(key, NextSessionId());
+        if (!session)
+            return nullptr;
+    }
+    session->last_seen_ns = now;
+
+    // set taken over after a stall
+    if (session->slot_set >= 0 && !TrackerAPI::GetInstance().TouchSlotSet(session->slot_set, session->id, now)) {
+        session->slot_set = -1;
+    }
+    if (session->slot_set < 0 && (session->last_acquire_ns == 0 || now - session->last_acquire_ns >= kAcquireRetryNs)) {
+        session->last_acquire_ns = now;
+        session->slot_set = TrackerAPI::GetInstance().AcquireSlotSet(session->id, now, session_timeout_ns_);
+        if (session->slot_set >= 0) {
+            std::cout << "Sender session " << session->id << " assigned slot set " << session->slot_set << std::endl;
+        }
+    }
+    return session;
+}
+
+void TrackerUDPServer::ExpireSessions(IngestWorker& worker, int64_t now, bool expire_all) {
+    worker.sessions.EraseIf([&](SenderSession& session) {
+        if (!expire_all && now - session.last_seen_ns < session_timeout_ns_)
+            return false;
+        if (session.slot_set >= 0) {
+            TrackerAPI::GetInstance().ReleaseSlotSet(session.slot_set, session.id);
+            std::cout << "Sender session " << session.id << " released slot set " << session.slot_set << std::endl;
+        }
+        return true;
+    });
+    worker.last_sweep_ns = now;
+}
+
+TrackerDeviceDriver* TrackerUDPServer::ResolveTracker(IngestWorker& worker, int set, const char* serial, int64_t now, TrackerRole& role) {
+    TrackerDeviceDriver* tracker = nullptr;
+    bool from_role = FindTrackerRole(serial, role);
+    if (!from_role) role = TrackerRole::Count;
+    if (from_role) {
+        // role in the sender's own slot set
+        if (set < 0) {
+            worker.dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        tracker = TrackerAPI::GetInstance().GetSlotTracker(set, role);
+    } else {
+        // registry changed, drop cached slots
+        uint64_t generation = TrackerAPI::GetInstance().GetGeneration();
+        if (generation != worker.registry_generation) {
+            ReleaseSlots(worker);
+            worker.registry_generation = generation;
+        }
+
+        SerialKey key;
+        if (!MakeSerialKey(serial, key))
+            return nullptr;
+        size_t index = SerialKeyHash()(key) & (kSerialSlotCapacity - 1);
+        while (worker.slots[index].tracker && !(worker.slots[index].key == key)) {
+            index = (index + 1) & (kSerialSlotCapacity - 1);
+        }
+        SerialSlot& slot = worker.slots[index];
+        if (slot.tracker) {
+            tracker = slot.tracker.get();
+        } else {
+            // keep one empty entry so probing always ends
+            if (worker.num_slots + 1 >= kSerialSlotCapacity)
+                return nullptr;
+            auto found = TrackerAPI::GetInstance().FindTracker(key);
+            if (!found)
+                return nullptr;
+            tracker = found.get();
+            slot.key = key;
+            slot.tracker = std::move(found);
+            worker.num_slots++;
+        }
+    }
+
+    // slot owned by another worker
+    if (!tracker->ClaimIngest(worker.id, now)) {
+        worker.dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    return tracker;
+}
+
+void TrackerUDPServer::UpdateSequence(SenderSession& session, uint32_t sequence) {
+    session.interval_received++;
+    if (!session.has_sequence) {
+        session.has_sequence = true;
+        session.interval_expected++;
+    } else if (static_cast<int32_t>(sequence - session.last_sequence) > 0) {
+        session.interval_expected += sequence - session.last_sequence;
+    } else {
+        // late or duplicate
+        return;
+    }
+    session.last_sequence = sequence;
+}
+
+void TrackerUDPServer::SendFeedback(IngestWorker& worker, int sockfd, int64_t now) {
+    UdpFeedbackPacket packet{};
+    packet.packet_type = PacketType::Feedback;
+    packet.desired_rate_hz = standby_ ? kStandbyRateHz : desired_rate_hz_.load(std::memory_order_relaxed);
+    uint16_t needed = NeededDevices();
+
+    worker.sessions.ForEach([&](SenderSession& session) {
+        // only senders heard from since their last feedback
+        if (now - session.last_feedback_ns < kFeedbackIntervalNs || session.last_seen_ns <= session.last_feedback_ns)
+            return;
+
+        packet.loss = -1.0f;
+        if (session.interval_expected > 0) {
+            float delivered = static_cast<float>(session.interval_received) / session.interval_expected;
+            packet.loss = delivered < 1.0f ? 1.0f - delivered : 0.0f;
+        }
+        // same for senders still waiting for a slot set, so they don't stop and restart their roles
+        packet.needed_devices = needed;
+        packet.latency_ms = session.slot_set >= 0 ? TrackerAPI::GetInstance().GetPublishLatency(session.slot_set) / 1e6f : 0.0f;
+        packet.received = session.received;
+
+        sockaddr_storage addr;
+        socklen_t addr_len = ToSockaddr(session, worker.family, addr);
+        sendto(sockfd, reinterpret_cast<const char*>(&packet), sizeof(packet), 0,
+               reinterpret_cast<const sockaddr*>(&addr), addr_len);
+
+        session.last_feedback_ns = now;
+        session.interval_received = 0;
+        session.interval_expected = 0;
+    });
+}
+
+void TrackerUDPServer::ReleaseSlots(IngestWorker& worker) {
+    for (auto& slot : worker.slots) {
+        if (!slot.tracker) continue;
+        slot.tracker->ReleaseIngest(worker.id);
+        slot = SerialSlot{};
+    }
+    worker.num_slots = 0;
+}
+
+void TrackerUDPServer::SendClockPings(IngestWorker& worker, int sockfd, int64_t now) {
+    UdpClockPingPacket packet{};
+    packet.packet_type = PacketType::ClockPing;
+
+    worker.sessions.ForEach([&](SenderSession& session) {
+        // only senders that are still sending
+        int64_t interval = session.clock.IsSynced() ? kClockPingIntervalNs : kClockPingFastNs;
+        if (now - session.last_ping_ns < interval || now - session.last_seen_ns >= kClockPingIntervalNs)
+            return;
+
+        sockaddr_storage addr;
+        socklen_t addr_len = ToSockaddr(session, worker.family, addr);
+        packet.driver_send_ns = NowNs();
+        sendto(sockfd, reinterpret_cast<const char*>(&packet), sizeof(packet), 0,
+               reinterpret_cast<const sockaddr*>(&addr), addr_len);
+        session.last_ping_ns = packet.driver_send_ns;
+    });
+}
+
+void TrackerUDPServer::HandleClockEcho(SenderSession& session, const UdpClockEchoPacket& packet, int64_t now) {
+    // stale or foreign echo
+    if (packet.driver_send_ns != session.last_ping_ns || packet.driver_send_ns > now)
+        return;
+
+    bool was_synced = session.clock.IsSynced();
+    session.clock.AddSample(packet.driver_send_ns, packet.sender_recv_ns, packet.sender_send_ns, now);
+    if (!was_synced && session.clock.IsSynced()) {
+        std::cout << "Sender session " << session.id << " clock synced, offset " << session.clock.GetOffsetMs()
+                  << " ms, round trip " << session.clock.GetRoundTripNs() / 1000 << " us" << std::endl;
+    }
+}
+
+void TrackerUDPServer::HandlePoseDatagram(IngestWorker& worker, SenderSession* session, const char* buffer, size_t size, int64_t now) {
+    int set = session ? session->slot_set : -1;
+    // capture time mapped into driver time, 0 when unknown
+    int64_t capture_ns = 0;
+    // publisher snapshots see the whole datagram or none of it
+    if (set >= 0) TrackerAPI::GetInstance().BeginSlotSetWrite(set);
+    // check batch, 1 + 45 * num_devices bytes (trailing padding allowed)
+    if (size != sizeof(UdpPosePacket)) {
+        size_t batch_size = BatchSize(buffer, size);
+        if (batch_size > 0) {
+            const UdpBatchPacket* batch = reinterpret_cast<const UdpBatchPacket*>(buffer);
+            TraceInstant("decode", "devices", batch->num_devices);
+            if (session && size == batch_size + kSequenceSize + kCaptureTimeSize && session->clock.IsSynced()) {
+                int64_t sender_capture_ns;
+                memcpy(&sender_capture_ns, buffer + batch_size + kSequenceSize, sizeof(sender_capture_ns));
+                // estimate error can put it slightly ahead of receipt
+                capture_ns = std::min(session->clock.ToDriverTime(sender_capture_ns), now);
+                TraceInstant("capture", "age_us", (now - capture_ns) / 1000);
+            }
+            for (uint8_t i = 0; i < batch->num_devices; ++i) {
+                HandlePosePacket(worker, set, batch->devices[i], now, capture_ns);
+            }
+        }
+    } else {
+        // single packet
+        const UdpPosePacket* packet = reinterpret_cast<const UdpPosePacket*>(buffer);
+        TraceInstant("decode", "devices", 1);
+        HandlePosePacket(worker, set, *packet, now, capture_ns);
+    }
+    if (set >= 0) {
+        // derived roles go out with the anchors they came from
+        TrackerAPI::GetInstance().SolveDerivedTrackers(set, now, capture_ns);
+        TrackerAPI::GetInstance().EndSlotSetWrite(set, now, capture_ns);
+    }
+}
+
+void TrackerUDPServer::ApplyStandbyDatagrams(IngestWorker& worker) {
+    // one datagram and one derived solve per sender and burst
+    worker.sessions.ForEach([&](SenderSession& session) {
+        if (session.standby_size == 0)
+            return;
+        HandlePoseDatagram(worker, &session, session.standby_datagram, session.standby_size, session.standby_recv_ns);
+        session.standby_size = 0;
+    });
+}
+
+void TrackerUDPServer::HandlePosePacket(IngestWorker& worker, int set, const UdpPosePacket& packet, int64_t now, int64_t capture_ns) {
     // null terminate
     char serial[17];
     strncpy(serial, packet.serial, 16);
@@ -50,74 +602,189 @@ void TrackerUDPServer::HandlePosePacket(const UdpPosePacket& packet) {
     HmdQuaternion_t rot{packet.rot[0], packet.rot[1], packet.rot[2], packet.rot[3]};
 
     switch (packet.device_type) {
-        case DeviceType::Tracker:
-            TrackerAPI::GetInstance().UpdateTrackerPose(serial, pos, rot);
+        case DeviceType::Tracker: {
+            TrackerRole role;
+            if (TrackerDeviceDriver* tracker = ResolveTracker(worker, set, serial, now, role)) {
+                // only poses keep derived trackers off a role
+                if (role != TrackerRole::Count) {
+                    TrackerAPI::GetInstance().MarkRoleSeen(set, role, now);
+                }
+                tracker->UpdatePose(pos, rot, capture_ns);
+                worker.updates.fetch_add(1, std::memory_order_relaxed);
+            }
             break;
+        }
         case DeviceType::HMD:
-            TrackerAPI::GetInstance().UpdateHMDPose(pos, rot);
+            if (set >= 0) {
+                TrackerAPI::GetInstance().UpdateHMDPose(pos, rot, set);
+                worker.updates.fetch_add(1, std::memory_order_relaxed);
+            }
             break;
         case DeviceType::LeftController:
-            TrackerAPI::GetInstance().UpdateControllerPose(true, pos, rot);
+            if (set >= 0) {
+                TrackerAPI::GetInstance().UpdateControllerPose(true, pos, rot, set);
+                worker.updates.fetch_add(1, std::memory_order_relaxed);
+            }
             break;
         case DeviceType::RightController:
-            TrackerAPI::GetInstance().UpdateControllerPose(false, pos, rot);
+            if (set >= 0) {
+                TrackerAPI::GetInstance().UpdateControllerPose(false, pos, rot, set);
+                worker.updates.fetch_add(1, std::memory_order_relaxed);
+            }
             break;
     }
 }
 
-void TrackerUDPServer::RunServer() {
+void TrackerUDPServer::HandleStatusPacket(IngestWorker& worker, int set, const UdpStatusPacket& packet, int64_t now) {
+    // null terminate
+    char serial[17];
+    strncpy(serial, packet.serial, 16);
+    serial[16] = '\0';
+
+    TrackerRole role;
+    if (TrackerDeviceDriver* tracker = ResolveTracker(worker, set, serial, now, role)) {
+        tracker->UpdateStatus(packet.battery,
+            (packet.flags & StatusFlag_Charging) != 0,
+            (packet.flags & StatusFlag_Connected) != 0);
+    }
+}
+
+void TrackerUDPServer::RunServer(IngestWorker& worker) {
 #ifdef _WIN32
     WSADATA wsaData;
     WSAStartup(MAKEWORD(2,2), &wsaData);
 #endif
-    int sockfd = socket(AF_INET, SOCK_DGRAM, 0);
+    int sockfd = OpenSocket(worker.port, kHasReusePort && workers_.size() > 1, multicast_group_, worker.family);
     if (sockfd < 0) {
-        std::cerr << "UDP socket creation failed" << std::endl;
-        return;
-    }
-    sockaddr_in servaddr{};
-    servaddr.sin_family = AF_INET;
-    servaddr.sin_addr.s_addr = INADDR_ANY;
-    servaddr.sin_port = htons(port_);
-    if (bind(sockfd, (struct sockaddr*)&servaddr, sizeof(servaddr)) < 0) {
-        std::cerr << "UDP socket bind failed" << std::endl;
 #ifdef _WIN32
-        closesocket(sockfd);
         WSACleanup();
-#else
-        close(sockfd);
 #endif
         return;
     }
-    std::cout << "UDP server listening on port " << port_ << std::endl;
+    std::cout << "UDP ingest worker " << worker.id << " listening on port " << worker.port
+              << (worker.family == AF_INET6 ? " (ipv4/ipv6)" : " (ipv4)");
+    if (!multicast_group_.empty()) {
+        std::cout << ", multicast group " << multicast_group_;
+    }
+    std::cout << std::endl;
+    TraceRecorder::GetInstance().SetThreadName("ingest " + std::to_string(worker.id));
+    bool standby = false;
+    bool idle_priority = false;
+    auto finish_wake = [&] {
+        {
+            std::lock_guard<std::mutex> lock(standby_mutex_);
+            worker.waking = false;
+        }
+        standby_cv_.notify_all();
+    };
     while (running_) {
+        if (standby != standby_.load(std::memory_order_relaxed)) {
+            standby = !standby;
+            SetRecvTimeout(sockfd, standby ? kStandbyRecvTimeoutMs : kRecvTimeoutMs);
+            if (standby) {
+                idle_priority = SetIdlePriority(true);
+            } else if (idle_priority) {
+                SetIdlePriority(false);
+                idle_priority = false;
+            }
+            if (!standby) {
+                // before newer datagrams are applied directly
+                ApplyStandbyDatagrams(worker);
+            }
+            if (!standby && worker.waking && !HasPendingDatagram(sockfd)) {
+                finish_wake();
+            }
+        }
+
         char buffer[1024]; // batch buffer
-        sockaddr_in cliaddr{};
+        sockaddr_storage cliaddr{};
         socklen_t len = sizeof(cliaddr);
         int n = recvfrom(sockfd, buffer, sizeof(buffer), 0, (struct sockaddr*)&cliaddr, &len);
-        
-        if (n >= sizeof(UdpPosePacket)) {
-            // check batch
-            if (n >= sizeof(UdpBatchPacket)) {
-                const UdpBatchPacket* batch = reinterpret_cast<const UdpBatchPacket*>(buffer);
-                if (batch->num_devices > 0 && batch->num_devices <= 8) {
-                    for (uint8_t i = 0; i < batch->num_devices; ++i) {
-                        HandlePosePacket(batch->devices[i]);
-                    }
-                }
+        int64_t now = NowNs();
+        // timeouts and errors are no datagram, buffer still holds the last one
+        size_t size = n > 0 ? static_cast<size_t>(n) : 0;
+
+        // per-sender slot set
+        int set = -1;
+        SenderSession* session = nullptr;
+        if (n > 0) {
+            TraceInstant("recv", "bytes", n);
+            worker.datagrams.fetch_add(1, std::memory_order_relaxed);
+            uint32_t scope_id;
+            SenderKey key = KeyFromSockaddr(cliaddr, scope_id);
+            session = UpdateSession(worker, key, now);
+            if (session) {
+                session->scope_id = scope_id;
+                session->received++;
+                set = session->slot_set;
+            }
+        }
+
+        if (size == sizeof(UdpStatusPacket) && static_cast<PacketType>(buffer[0]) == PacketType::Status) {
+            // status packet
+            UdpStatusPacket status;
+            memcpy(&status, buffer, sizeof(status));
+            TraceInstant("decode", "devices", 1);
+            HandleStatusPacket(worker, set, status, now);
+        } else if (size == sizeof(UdpClockEchoPacket) && static_cast<PacketType>(buffer[0]) == PacketType::ClockEcho) {
+            if (session) {
+                UdpClockEchoPacket echo;
+                memcpy(&echo, buffer, sizeof(echo));
+                HandleClockEcho(*session, echo, now);
+            }
+        } else if (size >= sizeof(UdpPosePacket)) {
+            // loss is counted on receipt, also for datagrams standby skips
+            size_t batch_size = BatchSize(buffer, size);
+            if (session && batch_size > 0 && (size == batch_size + kSequenceSize || size == batch_size + kSequenceSize + kCaptureTimeSize)) {
+                uint32_t sequence;
+                memcpy(&sequence, buffer + batch_size, sizeof(sequence));
+                UpdateSequence(*session, sequence);
+            }
+            if (standby && session && size <= sizeof(session->standby_datagram)) {
+                // newer datagrams replace it until the queue drains
+                memcpy(session->standby_datagram, buffer, size);
+                session->standby_size = size;
+                session->standby_recv_ns = now;
             } else {
-                // single packet
-                const UdpPosePacket* packet = reinterpret_cast<const UdpPosePacket*>(buffer);
-                HandlePosePacket(*packet);
+                HandlePoseDatagram(worker, session, buffer, size, now);
+            }
+        }
+        if (n > 0 && TraceRecorder::IsEnabled()) {
+            TraceRecorder::GetInstance().Complete("datagram", now, "set", set);
+        }
+
+        if (now - worker.last_backchannel_ns >= kBackChannelCheckNs) {
+            worker.last_backchannel_ns = now;
+            if (feedback_enabled_) SendFeedback(worker, sockfd, now);
+            // parked standby workers would read echoes late
+            if (clock_sync_enabled_ && !standby_) SendClockPings(worker, sockfd, now);
+        }
+
+        // release sets of silent senders
+        if (now - worker.last_sweep_ns > kSessionSweepNs) {
+            ExpireSessions(worker, now, false);
+        }
+
+        // standby: let datagrams queue up instead of waking for each one
+        if (standby || worker.waking) {
+            bool pending = n > 0 && HasPendingDatagram(sockfd);
+            if (standby && n > 0 && !pending) {
+                ApplyStandbyDatagrams(worker);
+                std::unique_lock<std::mutex> lock(standby_mutex_);
+                worker.waking = true;
+                standby_cv_.wait_for(lock, kStandbyPollInterval, [this] { return !standby_ || !running_; });
+            } else if (!standby && !pending) {
+                // queue drained, publishing may resume
+                finish_wake();
             }
         }
     }
+    ExpireSessions(worker, NowNs(), true);
+    ReleaseSlots(worker);
+    CloseSocket(sockfd);
 #ifdef _WIN32
-    closesocket(sockfd);
     WSACleanup();
-#else
-    close(sockfd);
 #endif
 }
 
-} // namespace vr 
\ No newline at end of file
+} // namespace vr
\ No newline at end of file
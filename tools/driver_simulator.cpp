@@ -0,0 +1,556 @@
+// headless driver simulator: loads the built driver library through
+// HmdDriverFactory, runs it against stub vrserver interfaces at a fixed hmd
+// rate and records every published pose
+
+#include "stub_driver_host.h"
+#include "tracker_udp_server.h"
+#include "opentrack_api.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <dlfcn.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+#ifndef OPENTRACK_DRIVER_PATH
+#define OPENTRACK_DRIVER_PATH ""
+#endif
+
+namespace {
+
+typedef void* (*HmdDriverFactoryFn)(const char* pInterfaceName, int* pReturnCode);
+
+const char* const kSettingsSection = "driver_OpenTrackDriver";
+
+struct Options {
+    std::string driver_path = OPENTRACK_DRIVER_PATH;
+    double hz = 90.0;
+    double send_hz = 120.0;
+    bool send_anchors = false;
+    double seconds = 5.0;
+    int port = 9000;
+    std::string host = "127.0.0.1"; // built-in sender destination, ipv4/ipv6 or a multicast group
+    std::string out_path;
+    double standby_start = 0.0;  // seconds, standby_end > standby_start enables
+    double standby_end = 0.0;
+    double clock_offset_ms = 0.0; // built-in sender's clock against the driver's
+    double clock_drift_ppm = 0.0;
+    std::vector<std::pair<std::string, std::string>> settings;
+};
+
+enum class PoseSource : uint8_t {
+    PoseUpdated = 0,
+    GetPose = 1
+};
+
+struct PoseRecord {
+    int64_t t_ns;
+    uint32_t device;
+    PoseSource source;
+    bool valid;
+    bool connected;
+    double pos[3];
+    double rot[4];
+};
+
+void PrintUsage() {
+    std::printf("usage: driver_simulator [driver_library] [--hz N] [--send-hz N] [--seconds N] [--port N]\n"
+                "                        [--host address] [--out poses.csv] [--set key=value]...\n"
+                "                        [--send all|anchors] [--standby start:end]\n"
+                "                        [--clock-offset-ms N] [--clock-drift-ppm N]\n"
+                "  --send-hz 0 disables the built-in sender\n"
+                "  --send anchors streams waist, feet, hmd and controllers only\n"
+                "  --standby puts the driver in standby between the two times in seconds\n"
+                "  --clock-* skew the clock the built-in sender stamps capture times with\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            options.driver_path = arg;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (arg == "--hz") options.hz = std::atof(value.c_str());
+        else if (arg == "--send-hz") options.send_hz = std::atof(value.c_str());
+        else if (arg == "--seconds") options.seconds = std::atof(value.c_str());
+        else if (arg == "--port") options.port = std::atoi(value.c_str());
+        else if (arg == "--host") options.host = value;
+        else if (arg == "--out") options.out_path = value;
+        else if (arg == "--clock-offset-ms") options.clock_offset_ms = std::atof(value.c_str());
+        else if (arg == "--clock-drift-ppm") options.clock_drift_ppm = std::atof(value.c_str());
+        else if (arg == "--send") {
+            if (value != "all" && value != "anchors") return false;
+            options.send_anchors = value == "anchors";
+        }
+        else if (arg == "--standby") {
+            if (std::sscanf(value.c_str(), "%lf:%lf", &options.standby_start, &options.standby_end) != 2 ||
+                options.standby_end <= options.standby_start) return false;
+        }
+        else if (arg == "--set") {
+            size_t eq = value.find('=');
+            if (eq == std::string::npos) return false;
+            options.settings.emplace_back(value.substr(0, eq), value.substr(eq + 1));
+        }
+        else return false;
+    }
+    return !options.driver_path.empty() && options.hz > 0.0 && options.seconds > 0.0 && options.send_hz >= 0.0;
+}
+
+struct DriverLibrary {
+#ifdef _WIN32
+    HMODULE module = nullptr;
+#else
+    void* module = nullptr;
+#endif
+    HmdDriverFactoryFn factory = nullptr;
+};
+
+bool LoadDriver(const std::string& path, DriverLibrary& library) {
+#ifdef _WIN32
+    library.module = LoadLibraryA(path.c_str());
+    if (!library.module) return false;
+    library.factory = reinterpret_cast<HmdDriverFactoryFn>(GetProcAddress(library.module, "HmdDriverFactory"));
+#else
+    library.module = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!library.module) {
+        std::fprintf(stderr, "%s\n", dlerror());
+        return false;
+    }
+    library.factory = reinterpret_cast<HmdDriverFactoryFn>(dlsym(library.module, "HmdDriverFactory"));
+#endif
+    return library.factory != nullptr;
+}
+
+// the provider belongs to the library, Cleanup() it first
+void UnloadDriver(DriverLibrary& library) {
+    if (!library.module) return;
+#ifdef _WIN32
+    FreeLibrary(library.module);
+#else
+    dlclose(library.module);
+#endif
+    library = DriverLibrary();
+}
+
+int64_t ElapsedNs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+double Percentile(std::vector<int64_t>& values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1e6;
+}
+
+// sends every role with a sequence number in pos.x, so the first pose that
+// carries it gives end-to-end latency. capture times are stamped on a
+// skewed clock and clock pings are echoed while waiting for the next send
+void RunSender(const Options& options, std::chrono::steady_clock::time_point start,
+               std::vector<std::atomic<int64_t>>& send_times, std::atomic<bool>& running) {
+    auto sender_clock = [&]() {
+        int64_t elapsed = ElapsedNs(start);
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(start.time_since_epoch()).count() + elapsed +
+               static_cast<int64_t>(options.clock_offset_ms * 1e6 + options.clock_drift_ppm * 1e-6 * elapsed);
+    };
+
+    sockaddr_storage addr{};
+    socklen_t addr_len = 0;
+    sockaddr_in& addr4 = reinterpret_cast<sockaddr_in&>(addr);
+    sockaddr_in6& addr6 = reinterpret_cast<sockaddr_in6&>(addr);
+    if (inet_pton(AF_INET, options.host.c_str(), &addr4.sin_addr) == 1) {
+        addr4.sin_family = AF_INET;
+        addr4.sin_port = htons(options.port);
+        addr_len = sizeof(addr4);
+    } else if (inet_pton(AF_INET6, options.host.c_str(), &addr6.sin6_addr) == 1) {
+        addr6.sin6_family = AF_INET6;
+        addr6.sin6_port = htons(options.port);
+        addr_len = sizeof(addr6);
+    } else {
+        std::fprintf(stderr, "sender: %s is not an IP address\n", options.host.c_str());
+        return;
+    }
+
+    int sock = socket(addr.ss_family, SOCK_DGRAM, 0);
+    if (sock < 0) return;
+
+    auto echo_pings = [&](std::chrono::steady_clock::time_point until) {
+        for (;;) {
+            auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(until - std::chrono::steady_clock::now());
+            if (remaining.count() <= 0) return;
+            fd_set readable;
+            FD_ZERO(&readable);
+            FD_SET(sock, &readable);
+            timeval timeout{static_cast<long>(remaining.count() / 1000000), static_cast<long>(remaining.count() % 1000000)};
+            if (select(sock + 1, &readable, nullptr, nullptr, &timeout) <= 0) continue;
+
+            uint8_t buffer[64];
+            sockaddr_storage from{};
+            socklen_t from_len = sizeof(from);
+            int n = recvfrom(sock, reinterpret_cast<char*>(buffer), sizeof(buffer), 0, reinterpret_cast<sockaddr*>(&from), &from_len);
+            int64_t received = sender_clock();
+            if (n != sizeof(vr::UdpClockPingPacket) || buffer[0] != static_cast<uint8_t>(vr::PacketType::ClockPing)) continue;
+            vr::UdpClockEchoPacket echo{};
+            echo.packet_type = vr::PacketType::ClockEcho;
+            memcpy(&echo.driver_send_ns, buffer + 1, sizeof(echo.driver_send_ns));
+            echo.sender_recv_ns = received;
+            echo.sender_send_ns = sender_clock();
+            sendto(sock, reinterpret_cast<const char*>(&echo), sizeof(echo), 0, reinterpret_cast<const sockaddr*>(&from), from_len);
+        }
+    };
+
+    vr::UdpBatchPacket batch{};
+    if (options.send_anchors) {
+        // standing body, the driver derives knees, elbows and chest
+        struct Anchor {
+            vr::DeviceType type;
+            const char* serial;
+            float pos[3];
+        };
+        const Anchor anchors[] = {
+            {vr::DeviceType::Tracker, "Waist", {0.0f, 0.93f, 0.0f}},
+            {vr::DeviceType::Tracker, "LeftFoot", {-0.09f, 0.07f, 0.0f}},
+            {vr::DeviceType::Tracker, "RightFoot", {0.09f, 0.07f, 0.0f}},
+            {vr::DeviceType::HMD, "HMD", {0.0f, 1.64f, 0.0f}},
+            {vr::DeviceType::LeftController, "LeftController", {-0.3f, 0.95f, -0.2f}},
+            {vr::DeviceType::RightController, "RightController", {0.3f, 0.95f, -0.2f}}
+        };
+        batch.num_devices = 6;
+        for (int i = 0; i < 6; ++i) {
+            batch.devices[i].device_type = anchors[i].type;
+            strncpy(batch.devices[i].serial, anchors[i].serial, sizeof(batch.devices[i].serial));
+            memcpy(batch.devices[i].pos, anchors[i].pos, sizeof(anchors[i].pos));
+            batch.devices[i].rot[0] = 1.0f;
+        }
+    } else {
+        batch.num_devices = 8;
+        for (int i = 0; i < 8; ++i) {
+            batch.devices[i].device_type = vr::DeviceType::Tracker;
+            strncpy(batch.devices[i].serial, opentrack::trackerRoleName(static_cast<opentrack::TrackerRole>(i)),
+                    sizeof(batch.devices[i].serial));
+            batch.devices[i].pos[1] = 1.0f;
+            batch.devices[i].rot[0] = 1.0f;
+        }
+    }
+    float base_x[8];
+    for (int i = 0; i < 8; ++i) {
+        base_x[i] = batch.devices[i].pos[0];
+    }
+
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.send_hz));
+    auto next = std::chrono::steady_clock::now();
+    // batch, sequence and capture time trailer
+    uint8_t datagram[sizeof(batch) + sizeof(uint32_t) + sizeof(int64_t)];
+    size_t batch_size = 1 + batch.num_devices * sizeof(vr::UdpPosePacket);
+    for (size_t seq = 1; running && seq < send_times.size(); ++seq) {
+        echo_pings(next);
+        next += period;
+        for (int i = 0; i < 8; ++i) {
+            batch.devices[i].pos[0] = base_x[i] + static_cast<float>(seq);
+        }
+        uint32_t sequence = static_cast<uint32_t>(seq);
+        int64_t capture = sender_clock();
+        send_times[seq].store(ElapsedNs(start), std::memory_order_release);
+        memcpy(datagram, &batch, batch_size);
+        memcpy(datagram + batch_size, &sequence, sizeof(sequence));
+        memcpy(datagram + batch_size + sizeof(sequence), &capture, sizeof(capture));
+        sendto(sock, reinterpret_cast<const char*>(datagram), batch_size + sizeof(sequence) + sizeof(capture), 0,
+               reinterpret_cast<const sockaddr*>(&addr), addr_len);
+    }
+
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+bool WriteRecords(const std::string& path, const std::vector<PoseRecord>& records) {
+    FILE* file = std::fopen(path.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "t_ns,source,device,valid,connected,x,y,z,qw,qx,qy,qz\n");
+    for (const auto& record : records) {
+        std::fprintf(file, "%lld,%s,%u,%d,%d,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                     static_cast<long long>(record.t_ns),
+                     record.source == PoseSource::PoseUpdated ? "pose_updated" : "get_pose",
+                     record.device, record.valid, record.connected,
+                     record.pos[0], record.pos[1], record.pos[2],
+                     record.rot[0], record.rot[1], record.rot[2], record.rot[3]);
+    }
+    std::fclose(file);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    DriverLibrary library;
+    if (!LoadDriver(options.driver_path, library)) {
+        std::fprintf(stderr, "failed to load HmdDriverFactory from %s\n", options.driver_path.c_str());
+        UnloadDriver(library);
+        return 1;
+    }
+    int error = 0;
+    auto* provider = static_cast<vr::IServerTrackedDeviceProvider*>(library.factory(vr::IServerTrackedDeviceProvider_Version, &error));
+    if (!provider) {
+        std::fprintf(stderr, "driver does not provide %s (%d)\n", vr::IServerTrackedDeviceProvider_Version, error);
+        UnloadDriver(library);
+        return 1;
+    }
+
+    vr::StubDriverContext context;
+    context.Properties().SetDisplayFrequency(static_cast<float>(options.hz));
+    context.Settings().SetInt32(kSettingsSection, "port", options.port, nullptr);
+    for (const auto& setting : options.settings) {
+        context.Settings().SetString(kSettingsSection, setting.first.c_str(), setting.second.c_str(), nullptr);
+    }
+
+    // record published poses
+    auto start = std::chrono::steady_clock::now();
+    std::mutex records_mutex;
+    std::vector<PoseRecord> records;
+    size_t frame_count = static_cast<size_t>(options.hz * options.seconds) + 1;
+    records.reserve(frame_count * vr::k_unMaxTrackedDeviceCount);
+
+    size_t max_seq = options.send_hz > 0.0 ? static_cast<size_t>(options.send_hz * options.seconds) + 2 : 0;
+    std::vector<std::atomic<int64_t>> send_times(max_seq);
+    std::vector<int64_t> first_seen(max_seq, 0);
+    std::vector<int64_t> latencies;
+    latencies.reserve(max_seq);
+    // pose time (publish + poseTimeOffset) against the true send time
+    std::vector<int64_t> pose_time_errors;
+    pose_time_errors.reserve(max_seq);
+
+    auto record = [&](uint32_t device, const vr::DriverPose_t& pose, PoseSource source) {
+        PoseRecord entry{};
+        entry.t_ns = ElapsedNs(start);
+        entry.device = device;
+        entry.source = source;
+        entry.valid = pose.poseIsValid;
+        entry.connected = pose.deviceIsConnected;
+        for (int i = 0; i < 3; ++i) entry.pos[i] = pose.vecPosition[i];
+        entry.rot[0] = pose.qRotation.w;
+        entry.rot[1] = pose.qRotation.x;
+        entry.rot[2] = pose.qRotation.y;
+        entry.rot[3] = pose.qRotation.z;
+
+        std::lock_guard<std::mutex> lock(records_mutex);
+        records.push_back(entry);
+
+        // first pose carrying a sent sequence number
+        double seq = pose.vecPosition[0];
+        if (source == PoseSource::PoseUpdated && seq >= 1.0 && seq < max_seq && seq == std::floor(seq)) {
+            size_t index = static_cast<size_t>(seq);
+            int64_t sent = send_times[index].load(std::memory_order_acquire);
+            if (sent != 0 && first_seen[index] == 0) {
+                first_seen[index] = entry.t_ns;
+                latencies.push_back(entry.t_ns - sent);
+                if (pose.poseTimeOffset != 0.0) {
+                    pose_time_errors.push_back(std::llabs(entry.t_ns + static_cast<int64_t>(pose.poseTimeOffset * 1e9) - sent));
+                }
+            }
+        }
+    };
+    context.Host().SetPoseCallback([&](uint32_t device, const vr::DriverPose_t& pose) {
+        record(device, pose, PoseSource::PoseUpdated);
+    });
+
+    if (provider->Init(&context) != vr::VRInitError_None) {
+        std::fprintf(stderr, "driver Init failed\n");
+        context.Host().SetPoseCallback(nullptr);
+        context.Host().DeactivateAll();
+        provider->Cleanup();
+        UnloadDriver(library);
+        return 1;
+    }
+
+    std::atomic<bool> sending{true};
+    std::thread sender;
+    if (max_seq > 0) {
+        sender = std::thread(RunSender, std::cref(options), start, std::ref(send_times), std::ref(sending));
+    }
+
+    // frame loop at the hmd rate
+    auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / options.hz));
+    auto next = std::chrono::steady_clock::now();
+    auto end = next + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(options.seconds));
+    std::vector<int64_t> frame_times;
+    frame_times.reserve(frame_count);
+    int64_t standby_enter_ns = 0;
+    int64_t standby_leave_ns = 0;
+    std::clock_t standby_cpu = 0;
+    std::clock_t loop_cpu = std::clock();
+    while (next < end) {
+        std::this_thread::sleep_until(next);
+        next += period;
+        frame_times.push_back(ElapsedNs(start));
+
+        // vrserver puts each device in standby, then the provider
+        double elapsed = frame_times.back() / 1e9;
+        if (options.standby_end > options.standby_start && standby_enter_ns == 0 && elapsed >= options.standby_start) {
+            for (auto* device : context.Host().GetDevices()) {
+                if (device) device->EnterStandby();
+            }
+            provider->EnterStandby();
+            standby_enter_ns = ElapsedNs(start);
+            standby_cpu = std::clock();
+        } else if (standby_enter_ns != 0 && standby_leave_ns == 0 && elapsed >= options.standby_end) {
+            standby_cpu = std::clock() - standby_cpu;
+            provider->LeaveStandby();
+            standby_leave_ns = ElapsedNs(start);
+        }
+        provider->RunFrame();
+
+        std::vector<vr::ITrackedDeviceServerDriver*> devices = context.Host().GetDevices();
+        for (uint32_t i = 0; i < devices.size(); ++i) {
+            if (devices[i]) record(i, devices[i]->GetPose(), PoseSource::GetPose);
+        }
+    }
+
+    loop_cpu = std::clock() - loop_cpu;
+    double loop_seconds = frame_times.empty() ? 0.0 : frame_times.back() / 1e9;
+
+    sending = false;
+    if (sender.joinable()) sender.join();
+    // publisher thread timing, before it stops
+    char publisher_stats[256] = {};
+    std::vector<vr::ITrackedDeviceServerDriver*> final_devices = context.Host().GetDevices();
+    if (final_devices.size() > 1 && final_devices[1]) {
+        final_devices[1]->DebugRequest("publisher_stats", publisher_stats, sizeof(publisher_stats));
+    }
+
+    // teardown as vrserver does it: devices, provider, then the library
+    size_t device_count = final_devices.size() - 1;
+    context.Host().SetPoseCallback(nullptr);
+    context.Host().DeactivateAll();
+    provider->Cleanup();
+    UnloadDriver(library);
+
+    // summary
+    size_t pose_updates = 0;
+    size_t get_poses = 0;
+    for (const auto& entry : records) {
+        (entry.source == PoseSource::PoseUpdated ? pose_updates : get_poses)++;
+    }
+    std::vector<int64_t> intervals;
+    for (size_t i = 1; i < frame_times.size(); ++i) {
+        intervals.push_back(frame_times[i] - frame_times[i - 1]);
+    }
+    // publish passes go out device 1..N back to back; a pass is mixed when
+    // its devices carry different sequence numbers (rounded, anchors are
+    // offset from it)
+    std::vector<int64_t> publish_intervals;
+    size_t passes = 0;
+    size_t mixed_passes = 0;
+    int64_t last_publish = 0;
+    double pass_seq = 0.0;
+    bool pass_mixed = false;
+    for (const auto& entry : records) {
+        if (entry.source != PoseSource::PoseUpdated) continue;
+        if (entry.device == 1) {
+            if (last_publish != 0) publish_intervals.push_back(entry.t_ns - last_publish);
+            last_publish = entry.t_ns;
+            if (pass_mixed) ++mixed_passes;
+            ++passes;
+            pass_seq = std::round(entry.pos[0]);
+            pass_mixed = false;
+        } else if (std::round(entry.pos[0]) != pass_seq) {
+            pass_mixed = true;
+        }
+    }
+    if (pass_mixed) ++mixed_passes;
+    size_t sent = 0;
+    for (size_t i = 1; i < max_seq; ++i) {
+        if (send_times[i].load() != 0) ++sent;
+    }
+
+    std::printf("driver:        %s\n", options.driver_path.c_str());
+    std::printf("devices:       %zu\n", device_count);
+    std::printf("frames:        %zu at %.1f Hz\n", frame_times.size(), options.hz);
+    std::printf("frame interval p50 %.3f ms, p99 %.3f ms\n", Percentile(intervals, 0.5), Percentile(intervals, 0.99));
+    std::printf("pose updates:  %zu (%.0f/s)\n", pose_updates, pose_updates / options.seconds);
+    std::printf("publish interval p50 %.3f ms, p99 %.3f ms, %zu passes, %zu mixed\n",
+                Percentile(publish_intervals, 0.5), Percentile(publish_intervals, 0.99), passes, mixed_passes);
+    std::printf("publisher:     %s\n", publisher_stats);
+    std::printf("GetPose calls: %zu\n", get_poses);
+    std::printf("property writes: %llu in %llu batches\n",
+                static_cast<unsigned long long>(context.Properties().GetWriteCount()),
+                static_cast<unsigned long long>(context.Properties().GetBatchCount()));
+    if (standby_leave_ns != 0) {
+        // how far the first pose after wake trails the sender, in batches
+        size_t standby_updates = 0;
+        int64_t wake_ns = 0;
+        double wake_seq = 0.0;
+        for (const auto& entry : records) {
+            if (entry.source != PoseSource::PoseUpdated) continue;
+            if (entry.t_ns >= standby_enter_ns && entry.t_ns < standby_leave_ns) ++standby_updates;
+            if (entry.t_ns >= standby_leave_ns && entry.device == 1 && wake_ns == 0) {
+                wake_ns = entry.t_ns;
+                wake_seq = std::round(entry.pos[0]);
+            }
+        }
+        size_t latest_seq = 0;
+        for (size_t i = 1; i < max_seq; ++i) {
+            int64_t sent_ns = send_times[i].load();
+            if (sent_ns != 0 && sent_ns <= wake_ns) latest_seq = i;
+        }
+        double standby_seconds = (standby_leave_ns - standby_enter_ns) / 1e9;
+        std::printf("standby:       %.1f s, %zu pose updates, cpu %.1f ms/s (%.1f ms/s awake)\n", standby_seconds, standby_updates,
+                    1000.0 * standby_cpu / CLOCKS_PER_SEC / standby_seconds,
+                    1000.0 * (loop_cpu - standby_cpu) / CLOCKS_PER_SEC / std::max(loop_seconds - standby_seconds, 1e-3));
+        std::printf("wake:          first publish after %.3f ms, %.0f batches behind\n",
+                    wake_ns != 0 ? (wake_ns - standby_leave_ns) / 1e6 : -1.0,
+                    wake_ns != 0 && max_seq > 0 ? latest_seq - wake_seq : 0.0);
+    }
+    if (max_seq > 0) {
+        std::printf("sent batches:  %zu at %.1f Hz, %zu seen\n", sent, options.send_hz, latencies.size());
+        std::printf("latency        p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+                    Percentile(latencies, 0.5), Percentile(latencies, 0.99), Percentile(latencies, 1.0));
+        std::printf("pose time error p50 %.3f ms, p99 %.3f ms, %zu timed (clock %+.1f ms, %+.0f ppm)\n",
+                    Percentile(pose_time_errors, 0.5), Percentile(pose_time_errors, 0.99), pose_time_errors.size(),
+                    options.clock_offset_ms, options.clock_drift_ppm);
+    }
+
+    if (!options.out_path.empty() && !WriteRecords(options.out_path, records)) {
+        std::fprintf(stderr, "failed to write %s\n", options.out_path.c_str());
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
@@ -0,0 +1,178 @@
+// ingest scaling benchmark: blasts batch packets from several senders at
+// the udp server and reports applied device updates for 1..N workers
+
+#include "stub_driver_host.h"
+#include "tracker_api.h"
+#include "tracker_device_driver.h"
+#include "tracker_udp_server.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct Options {
+    int max_workers = 4;
+    int devices = 128;
+    int senders = 16;
+    int seconds = 3;
+    int port = 19000;
+};
+
+void PrintUsage() {
+    std::printf("usage: ingest_benchmark [--max-workers N] [--devices N] [--senders N] [--seconds N] [--port N]\n");
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        int value = std::atoi(argv[++i]);
+        if (value <= 0) return false;
+        if (arg == "--max-workers") options.max_workers = value;
+        else if (arg == "--devices") options.devices = value;
+        else if (arg == "--senders") options.senders = value;
+        else if (arg == "--seconds") options.seconds = value;
+        else if (arg == "--port") options.port = value;
+        else return false;
+    }
+    return true;
+}
+
+std::string DeviceSerial(int index) {
+    char serial[16];
+    std::snprintf(serial, sizeof(serial), "bench_%03d", index);
+    return serial;
+}
+
+// sends every device in [first, last) in full batches until deadline
+void RunSender(int port, int first, int last, std::chrono::steady_clock::time_point deadline) {
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if (sock < 0) return;
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    std::vector<vr::UdpBatchPacket> batches;
+    for (int begin = first; begin < last; begin += 8) {
+        vr::UdpBatchPacket batch{};
+        batch.num_devices = static_cast<uint8_t>(std::min(8, last - begin));
+        for (int i = 0; i < batch.num_devices; ++i) {
+            vr::UdpPosePacket& device = batch.devices[i];
+            device.device_type = vr::DeviceType::Tracker;
+            std::string serial = DeviceSerial(begin + i);
+            std::memcpy(device.serial, serial.c_str(), serial.size());
+            device.pos[1] = 1.0f;
+            device.rot[0] = 1.0f;
+        }
+        batches.push_back(batch);
+    }
+
+    while (std::chrono::steady_clock::now() < deadline) {
+        for (const auto& batch : batches) {
+            sendto(sock, reinterpret_cast<const char*>(&batch), sizeof(batch), 0,
+                   reinterpret_cast<const sockaddr*>(&addr), sizeof(addr));
+        }
+    }
+
+#ifdef _WIN32
+    closesocket(sock);
+#else
+    close(sock);
+#endif
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, options)) {
+        PrintUsage();
+        return 1;
+    }
+
+#ifdef _WIN32
+    WSADATA wsaData;
+    WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+    vr::StubDriverContext context;
+    vr::InitServerDriverContext(&context);
+
+    // register and activate devices
+    std::vector<std::shared_ptr<TrackerDeviceDriver>> trackers;
+    for (int i = 0; i < options.devices; ++i) {
+        std::string serial = DeviceSerial(i);
+        auto tracker = std::make_shared<TrackerDeviceDriver>(serial, "OpenTrackServer", vr::TrackedDeviceClass_GenericTracker);
+        vr::TrackerAPI::GetInstance().RegisterTracker(serial, tracker);
+        context.Host().TrackedDeviceAdded(serial.c_str(), vr::TrackedDeviceClass_GenericTracker, tracker.get());
+        trackers.push_back(tracker);
+    }
+
+    std::printf("%d devices, %d senders, %d s per run\n", options.devices, options.senders, options.seconds);
+    std::printf("%8s %14s %14s %10s %8s\n", "workers", "datagrams/s", "updates/s", "dropped", "scale");
+
+    double baseline = 0.0;
+    for (int workers = 1; workers <= options.max_workers; ++workers) {
+        auto& server = vr::TrackerUDPServer::GetInstance();
+        if (!server.Start(options.port, workers)) {
+            std::fprintf(stderr, "failed to start server\n");
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        auto start = std::chrono::steady_clock::now();
+        auto deadline = start + std::chrono::seconds(options.seconds);
+        std::vector<std::thread> senders;
+        for (int s = 0; s < options.senders; ++s) {
+            int first = options.devices * s / options.senders;
+            int last = options.devices * (s + 1) / options.senders;
+            // without SO_REUSEPORT each worker has its own port
+#ifdef SO_REUSEPORT
+            int port = options.port;
+#else
+            int port = options.port + s % workers;
+#endif
+            senders.emplace_back(RunSender, port, first, last, deadline);
+        }
+        for (auto& sender : senders) {
+            sender.join();
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        vr::IngestStats stats = server.GetStats();
+        server.Stop();
+
+        double updates = stats.updates / elapsed;
+        if (workers == 1) baseline = updates;
+        std::printf("%8d %14.0f %14.0f %10llu %7.2fx\n", workers, stats.datagrams / elapsed, updates,
+                    static_cast<unsigned long long>(stats.dropped), baseline > 0.0 ? updates / baseline : 0.0);
+    }
+
+    context.Host().DeactivateAll();
+    for (int i = 0; i < options.devices; ++i) {
+        vr::TrackerAPI::GetInstance().UnregisterTracker(DeviceSerial(i));
+    }
+
+#ifdef _WIN32
+    WSACleanup();
+#endif
+    return 0;
+}
@@ -0,0 +1,246 @@
+#include "stub_driver_host.h"
+#include <cstring>
+#include <cstdlib>
+
+namespace vr {
+
+// properties
+
+ETrackedPropertyError StubProperties::ReadPropertyBatch(PropertyContainerHandle_t ulContainerHandle, PropertyRead_t* pBatch, uint32_t unBatchEntryCount) {
+    for (uint32_t i = 0; i < unBatchEntryCount; ++i) {
+        PropertyRead_t& read = pBatch[i];
+        float display_frequency = display_frequency_;
+        if (ulContainerHandle == TrackedDeviceToPropertyContainer(k_unTrackedDeviceIndex_Hmd) &&
+            read.prop == Prop_DisplayFrequency_Float && display_frequency > 0.0f) {
+            read.unTag = k_unFloatPropertyTag;
+            read.unRequiredBufferSize = sizeof(float);
+            if (read.unBufferSize < sizeof(float)) {
+                read.eError = TrackedProp_BufferTooSmall;
+                continue;
+            }
+            memcpy(read.pvBuffer, &display_frequency, sizeof(float));
+            read.eError = TrackedProp_Success;
+            continue;
+        }
+        read.unTag = k_unInvalidPropertyTag;
+        read.unRequiredBufferSize = 0;
+        read.eError = TrackedProp_UnknownProperty;
+    }
+    return TrackedProp_Success;
+}
+
+ETrackedPropertyError StubProperties::WritePropertyBatch(PropertyContainerHandle_t /*ulContainerHandle*/, PropertyWrite_t* pBatch, uint32_t unBatchEntryCount) {
+    batches_.fetch_add(1, std::memory_order_relaxed);
+    writes_.fetch_add(unBatchEntryCount, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < unBatchEntryCount; ++i) {
+        pBatch[i].eError = TrackedProp_Success;
+    }
+    return TrackedProp_Success;
+}
+
+const char* StubProperties::GetPropErrorNameFromEnum(ETrackedPropertyError error) {
+    return error == TrackedProp_Success ? "TrackedProp_Success" : "TrackedProp_Error";
+}
+
+PropertyContainerHandle_t StubProperties::TrackedDeviceToPropertyContainer(TrackedDeviceIndex_t nDevice) {
+    // 0 is the invalid container
+    return static_cast<PropertyContainerHandle_t>(nDevice) + 1;
+}
+
+// input
+
+EVRInputError StubDriverInput::CreateBooleanComponent(PropertyContainerHandle_t /*ulContainer*/, const char* /*pchName*/, VRInputComponentHandle_t* pHandle) {
+    *pHandle = next_handle_++;
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::UpdateBooleanComponent(VRInputComponentHandle_t /*ulComponent*/, bool /*bNewValue*/, double /*fTimeOffset*/) {
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::CreateScalarComponent(PropertyContainerHandle_t /*ulContainer*/, const char* /*pchName*/, VRInputComponentHandle_t* pHandle, EVRScalarType /*eType*/, EVRScalarUnits /*eUnits*/) {
+    *pHandle = next_handle_++;
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::UpdateScalarComponent(VRInputComponentHandle_t /*ulComponent*/, float /*fNewValue*/, double /*fTimeOffset*/) {
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::CreateHapticComponent(PropertyContainerHandle_t /*ulContainer*/, const char* /*pchName*/, VRInputComponentHandle_t* pHandle) {
+    *pHandle = next_handle_++;
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::CreateSkeletonComponent(PropertyContainerHandle_t /*ulContainer*/, const char* /*pchName*/, const char* /*pchSkeletonPath*/, const char* /*pchBasePosePath*/, EVRSkeletalTrackingLevel /*eSkeletalTrackingLevel*/, const VRBoneTransform_t* /*pGripLimitTransforms*/, uint32_t /*unGripLimitTransformCount*/, VRInputComponentHandle_t* pHandle) {
+    *pHandle = next_handle_++;
+    return VRInputError_None;
+}
+
+EVRInputError StubDriverInput::UpdateSkeletonComponent(VRInputComponentHandle_t /*ulComponent*/, EVRSkeletalMotionRange /*eMotionRange*/, const VRBoneTransform_t* /*pTransforms*/, uint32_t /*unTransformCount*/) {
+    return VRInputError_None;
+}
+
+// server host
+
+bool StubServerDriverHost::TrackedDeviceAdded(const char* /*pchDeviceSerialNumber*/, ETrackedDeviceClass /*eDeviceClass*/, ITrackedDeviceServerDriver* pDriver) {
+    uint32_t index;
+    {
+        std::lock_guard<std::mutex> lock(devices_mutex_);
+        if (devices_.size() >= k_unMaxTrackedDeviceCount)
+            return false;
+        index = static_cast<uint32_t>(devices_.size());
+        devices_.push_back(pDriver);
+    }
+    return pDriver->Activate(index) == VRInitError_None;
+}
+
+void StubServerDriverHost::TrackedDevicePoseUpdated(uint32_t unWhichDevice, const DriverPose_t& newPose, uint32_t /*unPoseStructSize*/) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    if (pose_callback_) {
+        pose_callback_(unWhichDevice, newPose);
+    }
+}
+
+void StubServerDriverHost::VsyncEvent(double /*vsyncTimeOffsetSeconds*/) {}
+
+void StubServerDriverHost::VendorSpecificEvent(uint32_t /*unWhichDevice*/, EVREventType /*eventType*/, const VREvent_Data_t& /*eventData*/, double /*eventTimeOffset*/) {}
+
+bool StubServerDriverHost::IsExiting() {
+    return false;
+}
+
+bool StubServerDriverHost::PollNextEvent(VREvent_t* /*pEvent*/, uint32_t /*uncbVREvent*/) {
+    return false;
+}
+
+void StubServerDriverHost::GetRawTrackedDevicePoses(float /*fPredictedSecondsFromNow*/, TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) {
+    memset(pTrackedDevicePoseArray, 0, sizeof(TrackedDevicePose_t) * unTrackedDevicePoseArrayCount);
+}
+
+void StubServerDriverHost::RequestRestart(const char* /*pchLocalizedReason*/, const char* /*pchExecutableToStart*/, const char* /*pchArguments*/, const char* /*pchWorkingDirectory*/) {}
+
+uint32_t StubServerDriverHost::GetFrameTimings(Compositor_FrameTiming* /*pTiming*/, uint32_t /*nFrames*/) {
+    return 0;
+}
+
+void StubServerDriverHost::SetDisplayEyeToHead(uint32_t /*unWhichDevice*/, const HmdMatrix34_t& /*eyeToHeadLeft*/, const HmdMatrix34_t& /*eyeToHeadRight*/) {}
+
+void StubServerDriverHost::SetDisplayProjectionRaw(uint32_t /*unWhichDevice*/, const HmdRect2_t& /*eyeLeft*/, const HmdRect2_t& /*eyeRight*/) {}
+
+void StubServerDriverHost::SetRecommendedRenderTargetSize(uint32_t /*unWhichDevice*/, uint32_t /*nWidth*/, uint32_t /*nHeight*/) {}
+
+std::vector<ITrackedDeviceServerDriver*> StubServerDriverHost::GetDevices() {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    return devices_;
+}
+
+void StubServerDriverHost::DeactivateAll() {
+    std::lock_guard<std::mutex> lock(devices_mutex_);
+    for (auto* device : devices_) {
+        if (device) device->Deactivate();
+    }
+    devices_.assign(1, nullptr);
+}
+
+void StubServerDriverHost::SetPoseCallback(PoseCallback callback) {
+    std::lock_guard<std::mutex> lock(callback_mutex_);
+    pose_callback_ = std::move(callback);
+}
+
+// settings
+
+const char* StubSettings::GetSettingsErrorNameFromEnum(EVRSettingsError eError) {
+    return eError == VRSettingsError_None ? "VRSettingsError_None" : "VRSettingsError_ReadFailed";
+}
+
+void StubSettings::SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, EVRSettingsError* peError) {
+    SetString(pchSection, pchSettingsKey, bValue ? "1" : "0", peError);
+}
+
+void StubSettings::SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, EVRSettingsError* peError) {
+    SetString(pchSection, pchSettingsKey, std::to_string(nValue).c_str(), peError);
+}
+
+void StubSettings::SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, EVRSettingsError* peError) {
+    SetString(pchSection, pchSettingsKey, std::to_string(flValue).c_str(), peError);
+}
+
+void StubSettings::SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, EVRSettingsError* peError) {
+    std::lock_guard<std::mutex> lock(values_mutex_);
+    values_[std::string(pchSection) + "/" + pchSettingsKey] = pchValue;
+    if (peError) *peError = VRSettingsError_None;
+}
+
+bool StubSettings::Find(const char* pchSection, const char* pchSettingsKey, std::string& value, EVRSettingsError* peError) {
+    std::lock_guard<std::mutex> lock(values_mutex_);
+    auto it = values_.find(std::string(pchSection) + "/" + pchSettingsKey);
+    bool found = it != values_.end();
+    if (found) value = it->second;
+    if (peError) *peError = found ? VRSettingsError_None : VRSettingsError_ReadFailed;
+    return found;
+}
+
+bool StubSettings::GetBool(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) {
+    std::string value;
+    return Find(pchSection, pchSettingsKey, value, peError) && (value == "1" || value == "true");
+}
+
+int32_t StubSettings::GetInt32(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) {
+    std::string value;
+    return Find(pchSection, pchSettingsKey, value, peError) ? std::atoi(value.c_str()) : 0;
+}
+
+float StubSettings::GetFloat(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) {
+    std::string value;
+    return Find(pchSection, pchSettingsKey, value, peError) ? static_cast<float>(std::atof(value.c_str())) : 0.0f;
+}
+
+void StubSettings::GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, EVRSettingsError* peError) {
+    std::string value;
+    Find(pchSection, pchSettingsKey, value, peError);
+    if (unValueLen > 0) {
+        strncpy(pchValue, value.c_str(), unValueLen - 1);
+        pchValue[unValueLen - 1] = '\0';
+    }
+}
+
+void StubSettings::RemoveSection(const char* pchSection, EVRSettingsError* peError) {
+    std::lock_guard<std::mutex> lock(values_mutex_);
+    std::string prefix = std::string(pchSection) + "/";
+    for (auto it = values_.begin(); it != values_.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? values_.erase(it) : std::next(it);
+    }
+    if (peError) *peError = VRSettingsError_None;
+}
+
+void StubSettings::RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) {
+    std::lock_guard<std::mutex> lock(values_mutex_);
+    values_.erase(std::string(pchSection) + "/" + pchSettingsKey);
+    if (peError) *peError = VRSettingsError_None;
+}
+
+// context
+
+void* StubDriverContext::GetGenericInterface(const char* pchInterfaceVersion, EVRInitError* peError) {
+    void* result = nullptr;
+    if (0 == strcmp(pchInterfaceVersion, IVRProperties_Version)) {
+        result = static_cast<IVRProperties*>(&properties_);
+    } else if (0 == strcmp(pchInterfaceVersion, IVRDriverInput_Version)) {
+        result = static_cast<IVRDriverInput*>(&input_);
+    } else if (0 == strcmp(pchInterfaceVersion, IVRServerDriverHost_Version)) {
+        result = static_cast<IVRServerDriverHost*>(&host_);
+    } else if (0 == strcmp(pchInterfaceVersion, IVRSettings_Version)) {
+        result = static_cast<IVRSettings*>(&settings_);
+    }
+    if (peError) {
+        *peError = result ? VRInitError_None : VRInitError_Init_InterfaceNotFound;
+    }
+    return result;
+}
+
+DriverHandle_t StubDriverContext::GetDriverHandle() {
+    return 1;
+}
+
+} // namespace vr
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <openvr_driver.h>
+
+namespace vr {
+
+// minimal stand-ins for the vrserver side of the driver interfaces, so the
+// driver can run without SteamVR
+
+class StubProperties : public IVRProperties {
+public:
+    ETrackedPropertyError ReadPropertyBatch(PropertyContainerHandle_t ulContainerHandle, PropertyRead_t* pBatch, uint32_t unBatchEntryCount) override;
+    ETrackedPropertyError WritePropertyBatch(PropertyContainerHandle_t ulContainerHandle, PropertyWrite_t* pBatch, uint32_t unBatchEntryCount) override;
+    const char* GetPropErrorNameFromEnum(ETrackedPropertyError error) override;
+    PropertyContainerHandle_t TrackedDeviceToPropertyContainer(TrackedDeviceIndex_t nDevice) override;
+
+    uint64_t GetBatchCount() const { return batches_; }
+    uint64_t GetWriteCount() const { return writes_; }
+
+    // Prop_DisplayFrequency_Float of the hmd container, 0 leaves it unset
+    void SetDisplayFrequency(float hz) { display_frequency_ = hz; }
+
+private:
+    std::atomic<float> display_frequency_{0.0f};
+    std::atomic<uint64_t> batches_{0};
+    std::atomic<uint64_t> writes_{0};
+};
+
+class StubDriverInput : public IVRDriverInput {
+public:
+    EVRInputError CreateBooleanComponent(PropertyContainerHandle_t ulContainer, const char* pchName, VRInputComponentHandle_t* pHandle) override;
+    EVRInputError UpdateBooleanComponent(VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) override;
+    EVRInputError CreateScalarComponent(PropertyContainerHandle_t ulContainer, const char* pchName, VRInputComponentHandle_t* pHandle, EVRScalarType eType, EVRScalarUnits eUnits) override;
+    EVRInputError UpdateScalarComponent(VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) override;
+    EVRInputError CreateHapticComponent(PropertyContainerHandle_t ulContainer, const char* pchName, VRInputComponentHandle_t* pHandle) override;
+    EVRInputError CreateSkeletonComponent(PropertyContainerHandle_t ulContainer, const char* pchName, const char* pchSkeletonPath, const char* pchBasePosePath, EVRSkeletalTrackingLevel eSkeletalTrackingLevel, const VRBoneTransform_t* pGripLimitTransforms, uint32_t unGripLimitTransformCount, VRInputComponentHandle_t* pHandle) override;
+    EVRInputError UpdateSkeletonComponent(VRInputComponentHandle_t ulComponent, EVRSkeletalMotionRange eMotionRange, const VRBoneTransform_t* pTransforms, uint32_t unTransformCount) override;
+
+private:
+    std::atomic<VRInputComponentHandle_t> next_handle_{1};
+};
+
+class StubServerDriverHost : public IVRServerDriverHost {
+public:
+    bool TrackedDeviceAdded(const char* pchDeviceSerialNumber, ETrackedDeviceClass eDeviceClass, ITrackedDeviceServerDriver* pDriver) override;
+    void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const DriverPose_t& newPose, uint32_t unPoseStructSize) override;
+    void VsyncEvent(double vsyncTimeOffsetSeconds) override;
+    void VendorSpecificEvent(uint32_t unWhichDevice, EVREventType eventType, const VREvent_Data_t& eventData, double eventTimeOffset) override;
+    bool IsExiting() override;
+    bool PollNextEvent(VREvent_t* pEvent, uint32_t uncbVREvent) override;
+    void GetRawTrackedDevicePoses(float fPredictedSecondsFromNow, TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) override;
+    void RequestRestart(const char* pchLocalizedReason, const char* pchExecutableToStart, const char* pchArguments, const char* pchWorkingDirectory) override;
+    uint32_t GetFrameTimings(Compositor_FrameTiming* pTiming, uint32_t nFrames) override;
+    void SetDisplayEyeToHead(uint32_t unWhichDevice, const HmdMatrix34_t& eyeToHeadLeft, const HmdMatrix34_t& eyeToHeadRight) override;
+    void SetDisplayProjectionRaw(uint32_t unWhichDevice, const HmdRect2_t& eyeLeft, const HmdRect2_t& eyeRight) override;
+    void SetRecommendedRenderTargetSize(uint32_t unWhichDevice, uint32_t nWidth, uint32_t nHeight) override;
+
+    // activated devices, index is the device id (0 is reserved for the hmd)
+    std::vector<ITrackedDeviceServerDriver*> GetDevices();
+    void DeactivateAll();
+
+    // called from whichever thread publishes the pose
+    using PoseCallback = std::function<void(uint32_t device, const DriverPose_t& pose)>;
+    void SetPoseCallback(PoseCallback callback);
+
+private:
+    std::mutex callback_mutex_;
+    PoseCallback pose_callback_;
+    std::mutex devices_mutex_;
+    std::vector<ITrackedDeviceServerDriver*> devices_{nullptr};
+};
+
+class StubSettings : public IVRSettings {
+public:
+    const char* GetSettingsErrorNameFromEnum(EVRSettingsError eError) override;
+    void SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, EVRSettingsError* peError) override;
+    void SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, EVRSettingsError* peError) override;
+    void SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, EVRSettingsError* peError) override;
+    void SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, EVRSettingsError* peError) override;
+    bool GetBool(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) override;
+    int32_t GetInt32(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) override;
+    float GetFloat(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) override;
+    void GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, EVRSettingsError* peError) override;
+    void RemoveSection(const char* pchSection, EVRSettingsError* peError) override;
+    void RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, EVRSettingsError* peError) override;
+
+private:
+    bool Find(const char* pchSection, const char* pchSettingsKey, std::string& value, EVRSettingsError* peError);
+
+    std::mutex values_mutex_;
+    std::map<std::string, std::string> values_;
+};
+
+class StubDriverContext : public IVRDriverContext {
+public:
+    void* GetGenericInterface(const char* pchInterfaceVersion, EVRInitError* peError) override;
+    DriverHandle_t GetDriverHandle() override;
+
+    StubProperties& Properties() { return properties_; }
+    StubDriverInput& Input() { return input_; }
+    StubServerDriverHost& Host() { return host_; }
+    StubSettings& Settings() { return settings_; }
+
+private:
+    StubProperties properties_;
+    StubDriverInput input_;
+    StubServerDriverHost host_;
+    StubSettings settings_;
+};
+
+} // namespace vr